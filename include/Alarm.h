@@ -0,0 +1,74 @@
+/*********************************************************************************************************
+ * Threshold Alarms
+ *
+ * Description:
+ *   High/low limits on temperature and humidity, and rate-of-change limits on both, for every sensor of
+ *    the array (ALARMS). Readings are checked in the sensor task right after the frame is decoded and
+ *    before the sample is published, so an alarm never waits behind the queue, the filter or the
+ *    display. The alarm output (ALARM_PIN) is switched from there, and loop() is handed an AlarmEvent
+ *    that pre-empts the normal display update with a full-screen alert.
+ *
+ * Latency:
+ *   - Output pin: the sensor task runs at the highest priority of the application tasks and nothing
+ *      between the end of the read and the pin write blocks, so the pin follows the reading within one
+ *      tick (the read yields a tick at a time while the frame is captured) plus the evaluation itself,
+ *      a few microseconds. alarmStats().maxPinLatencyUs is measured from the end of the read.
+ *   - Screen: loop() checks for alarm events before every state, so the alert waits for at most the
+ *      state pass already running (its worst case is the profiler's max), the sprite pushes still queued
+ *      (DISPLAY_PUSH_QUEUE) and the alert's own draw. A sleeping panel adds the 120 ms ST7789 sleep out
+ *      time. Alerts later than ALARM_SCREEN_BUDGET_MS after the end of the read are counted.
+ *
+ * Notes:
+ *   - Level alarms clear ALARM_HYSTERESIS_T/RH back inside their limit, so a reading sitting on the
+ *      limit does not toggle the output.
+ *   - Rates are measured against a reference reading at least ALARM_RATE_WINDOW_MS old, so the ±1 LSB
+ *      noise of a single read does not count as a rate.
+ *   - A failed read changes nothing: active alarms stay active until a good reading clears them.
+ *   - Acknowledging (any button) takes the alert off the screen, the output stays on until the alarm
+ *      clears. A new alarm shows the alert again.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SensorSample.h"
+
+// Alarm conditions, one bit each in an alarm mask
+enum class AlarmKind : uint8_t {
+  T_HIGH,
+  T_LOW,
+  RH_HIGH,
+  RH_LOW,
+  T_RATE,
+  RH_RATE,
+  COUNT
+};
+
+// Change of the alarms of one sensor, handed from the sensor task to loop()
+struct AlarmEvent {
+  SensorSample sample; // reading that raised or cleared the alarms
+  uint8_t active;      // alarms active after the reading, bit per AlarmKind
+  uint8_t raised;      // alarms the reading raised
+  int64_t landedUs;    // esp_timer_get_time() at the end of the read
+};
+
+// Latency and counters of the alarm paths
+struct AlarmStats {
+  uint32_t raised;             // alarms raised since boot
+  uint32_t maxPinLatencyUs;    // worst end of read to output pin switched
+  uint32_t maxScreenLatencyUs; // worst end of read to alert on screen
+  uint32_t overBudget;         // alerts later than ALARM_SCREEN_BUDGET_MS
+  uint32_t dropped;            // events lost to a full queue (the output pin is never affected)
+};
+
+void alarmsBegin();                                    // set up the output pin, the calling task is woken
+                                                       //  by every alarm event
+void evaluateAlarms(const SensorSample &sample, int64_t landedUs); // sensor task: check a reading
+bool alarmPending();                                   // loop(): an event is waiting for the screen
+void handleAlarmEvents();                              // loop(): take the events, draw or remove the alert
+bool alarmScreenVisible();                             // the alert covers the screen
+void acknowledgeAlarm();                               // take the alert off the screen, the output stays on
+uint8_t activeAlarms(uint8_t sensor);                  // bit per AlarmKind
+const char *alarmKindName(AlarmKind kind);             // e.g. "t_high"
+AlarmStats alarmStats();
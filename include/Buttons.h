@@ -0,0 +1,20 @@
+/*********************************************************************************************************
+ * Buttons
+ *
+ * Description:
+ *   Interrupt-driven handling of the two T-Display-S3 buttons (GPIO0 and GPIO14, active low). A press
+ *    is latched by the GPIO interrupt, debounced, and wakes the loop task through its task
+ *    notification, so a blocked WAIT state reacts at once instead of on the next sample.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Bits returned by takeButtonPresses()
+const uint8_t BUTTON_1 = 1 << 0; // GPIO0 (BOOT), left of the USB port with the screen facing up
+const uint8_t BUTTON_2 = 1 << 1; // GPIO14
+
+void buttonsBegin();         // attach the interrupts, the calling task is the one woken on a press
+uint8_t takeButtonPresses(); // presses since the last call (BUTTON_x bits), clears them
@@ -0,0 +1,490 @@
+/*********************************************************************************************************
+ * Project Configuration
+ *
+ * Description:
+ *   Compile-time settings shared by the sketch and its modules. Every value can be overridden from
+ *    platformio.ini with a build flag, e.g. build_flags = -D DHT11_PIN=2
+**********************************************************************************************************/
+
+#pragma once
+
+// DHT11 Sensor
+#ifndef DHT11_PIN
+#define DHT11_PIN 1 // DHT11 data pin
+#endif
+
+// Sensor array (see SensorArray.h), up to 8 sensors read round-robin, the first one is the primary
+//  sensor behind the history, trend graph, flash log and telemetry
+//  e.g. build_flags = -D 'SENSOR_PINS={1,2,3}' -D 'SENSOR_TYPES={DhtType::Dht11,DhtType::Dht11,DhtType::Dht22}'
+#ifndef SENSOR_PINS
+#define SENSOR_PINS { DHT11_PIN }
+#endif
+#ifndef SENSOR_TYPES
+#define SENSOR_TYPES { DhtType::Dht11 }
+#endif
+
+// Sensor backend
+//  DHT_BACKEND_RMT      = the 40-bit frame is captured in the background by the RMT peripheral
+//  DHT_BACKEND_ADAFRUIT = blocking bit-banged read through the Adafruit DHT library
+#define DHT_BACKEND_RMT      0
+#define DHT_BACKEND_ADAFRUIT 1
+#ifndef DHT_BACKEND
+#define DHT_BACKEND DHT_BACKEND_RMT
+#endif
+
+// Disconnect detection
+#ifndef DHT_LINE_CHECK
+#define DHT_LINE_CHECK 1             // check the line is pulled up before each start pulse (needs the
+#endif                               //  pull-up resistor fitted on DHT11 modules)
+#ifndef SENSOR_BACKOFF_MAX_MS
+#define SENSOR_BACKOFF_MAX_MS 32000  // longest retry interval while the sensor is not answering
+#endif
+
+// Sensor acquisition task
+#ifndef SENSOR_READ_INTERVAL_MS
+#define SENSOR_READ_INTERVAL_MS 2000 // read sensor every 2 seconds (recommended interval)
+#endif
+#ifndef SENSOR_TASK_CORE
+#define SENSOR_TASK_CORE 0           // core 1 runs the Arduino loop()
+#endif
+#ifndef SENSOR_TASK_PRIORITY
+#define SENSOR_TASK_PRIORITY 3       // above loop() (priority 1) so reads start on time
+#endif
+#ifndef SENSOR_TASK_STACK
+#define SENSOR_TASK_STACK 4096       // stack size in bytes
+#endif
+#ifndef SENSOR_QUEUE_LENGTH
+#define SENSOR_QUEUE_LENGTH 8        // readings buffered between the tasks (power of two)
+#endif
+
+// Adaptive sampling rate (per sensor)
+//  1 = the read interval doubles while readings are stable, up to ADAPTIVE_INTERVAL_MAX_MS, and snaps
+//      back to SENSOR_READ_INTERVAL_MS as soon as a reading changes faster than the rate thresholds
+//  0 = every sensor is read every SENSOR_READ_INTERVAL_MS
+#ifndef ADAPTIVE_SAMPLING
+#define ADAPTIVE_SAMPLING 1
+#endif
+#ifndef ADAPTIVE_INTERVAL_MAX_MS
+#define ADAPTIVE_INTERVAL_MAX_MS 30000 // longest interval on a stable site (30-60 s is sensible)
+#endif
+#ifndef ADAPTIVE_STABLE_T
+#define ADAPTIVE_STABLE_T 2            // °C x 10, a change up to this between reads counts as stable
+#endif
+#ifndef ADAPTIVE_STABLE_RH
+#define ADAPTIVE_STABLE_RH 10          // % x 10, a change up to this between reads counts as stable (one DHT11 LSB)
+#endif
+#ifndef ADAPTIVE_RATE_T
+#define ADAPTIVE_RATE_T 10             // °C x 10 per minute, a faster change snaps back to full rate
+#endif
+#ifndef ADAPTIVE_RATE_RH
+#define ADAPTIVE_RATE_RH 50            // % x 10 per minute, a faster change snaps back to full rate
+#endif
+#ifndef ADAPTIVE_RATE_WINDOW_MS
+#define ADAPTIVE_RATE_WINDOW_MS 60000  // rates are measured against a reading at least this old
+#endif
+
+// Noise filter between acquisition and the redraw decision
+#ifndef FILTER_MEDIAN_WINDOW
+#define FILTER_MEDIAN_WINDOW 3    // samples in the median window (odd)
+#endif
+#ifndef DEADBAND_TEMPERATURE
+#define DEADBAND_TEMPERATURE 2    // °C x 10 the temperature must move past before it is reported
+#endif
+#ifndef DEADBAND_HUMIDITY
+#define DEADBAND_HUMIDITY 10      // % x 10 the humidity must move past (one DHT11 LSB) before it is reported
+#endif
+
+// Sample history
+#ifndef HISTORY_WINDOW
+#define HISTORY_WINDOW 64              // samples per aggregate window (power of two)
+#endif
+#ifndef HISTORY_HOT_SAMPLES
+#define HISTORY_HOT_SAMPLES 256        // recent samples kept in internal SRAM (multiple of the window)
+#endif
+#ifndef HISTORY_COLD_SAMPLES
+#define HISTORY_COLD_SAMPLES 524288    // older samples kept in PSRAM, 3 MB (~12 days at 2 s)
+#endif
+
+// Flash log (LittleFS partition, see partitions.csv)
+#ifndef FLASH_LOG
+#define FLASH_LOG 1                    // 1 = log every valid sample to flash
+#endif
+#ifndef LOG_PAGE_SIZE
+#define LOG_PAGE_SIZE 256              // bytes per write, one flash program page
+#endif
+#ifndef LOG_MAX_BYTES
+#define LOG_MAX_BYTES (4UL << 20)      // log size before it is rotated to the backup file
+#endif
+
+// Wi-Fi station credentials (used by the network features)
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD ""
+#endif
+#ifndef DEVICE_NAME
+#define DEVICE_NAME "t-display-s3"   // name reported by the network features
+#endif
+
+// Telemetry uplink (batched HTTP POST)
+#ifndef TELEMETRY
+#define TELEMETRY 0                    // 1 = upload samples to TELEMETRY_HOST
+#endif
+#ifndef TELEMETRY_HOST
+#define TELEMETRY_HOST "192.168.1.10"
+#endif
+#ifndef TELEMETRY_PORT
+#define TELEMETRY_PORT 8080
+#endif
+#ifndef TELEMETRY_PATH
+#define TELEMETRY_PATH "/api/telemetry"
+#endif
+#ifndef TELEMETRY_BATCH
+#define TELEMETRY_BATCH 60             // samples per batch
+#endif
+#ifndef TELEMETRY_MAX_LATENCY_MS
+#define TELEMETRY_MAX_LATENCY_MS 300000 // longest a sample waits in the batch (5 minutes)
+#endif
+#ifndef TELEMETRY_T_THRESHOLD
+#define TELEMETRY_T_THRESHOLD 10       // °C x 10 change that sends the batch at once
+#endif
+#ifndef TELEMETRY_RH_THRESHOLD
+#define TELEMETRY_RH_THRESHOLD 50      // % x 10 change that sends the batch at once
+#endif
+#ifndef TELEMETRY_LINGER_MS
+#define TELEMETRY_LINGER_MS 5000       // connection kept open after a batch for a following one
+#endif
+#ifndef TELEMETRY_TIMEOUT_MS
+#define TELEMETRY_TIMEOUT_MS 10000     // Wi-Fi association and HTTP answer timeout
+#endif
+#ifndef TELEMETRY_RETRIES
+#define TELEMETRY_RETRIES 2            // retries of a failed upload before the batch is dropped
+#endif
+#ifndef TELEMETRY_PAYLOAD_SIZE
+#define TELEMETRY_PAYLOAD_SIZE 3072    // preallocated JSON body (about 38 bytes per sample)
+#endif
+#ifndef TELEMETRY_TASK_STACK
+#define TELEMETRY_TASK_STACK 6144      // uplink task stack size in bytes
+#endif
+
+// Metrics server (Prometheus /metrics and JSON /api/samples)
+#ifndef METRICS_SERVER
+#define METRICS_SERVER 0               // 1 = serve the readings on the local network
+#endif
+#ifndef METRICS_PORT
+#define METRICS_PORT 80
+#endif
+#ifndef METRICS_BUFFER_SIZE
+#define METRICS_BUFFER_SIZE 1436       // preallocated response buffer, one TCP segment
+#endif
+#ifndef METRICS_CHUNK
+#define METRICS_CHUNK 32               // history samples copied per lock in /api/samples
+#endif
+#ifndef METRICS_SAMPLES_MAX
+#define METRICS_SAMPLES_MAX 1024       // samples per /api/samples page
+#endif
+#ifndef METRICS_SUMMARY_WINDOWS
+#define METRICS_SUMMARY_WINDOWS 28     // history windows in the /metrics aggregates (~1 hour at 2 s)
+#endif
+#ifndef METRICS_TIMEOUT_MS
+#define METRICS_TIMEOUT_MS 2000        // longest wait for a slow client
+#endif
+#ifndef METRICS_CONNECT_TIMEOUT_MS
+#define METRICS_CONNECT_TIMEOUT_MS 10000 // Wi-Fi association timeout
+#endif
+#ifndef METRICS_RETRY_MS
+#define METRICS_RETRY_MS 30000         // wait before the next association attempt
+#endif
+#ifndef METRICS_POLL_MS
+#define METRICS_POLL_MS 20             // accept poll interval while idle
+#endif
+#ifndef METRICS_TASK_STACK
+#define METRICS_TASK_STACK 4096        // server task stack size in bytes
+#endif
+
+// Over-the-air firmware updates (see OtaUpdate.h)
+#ifndef OTA_UPDATE
+#define OTA_UPDATE 0                   // 1 = fetch new firmware from OTA_HOST into the inactive app slot
+#endif
+#ifndef OTA_HOST
+#define OTA_HOST "192.168.1.10"
+#endif
+#ifndef OTA_PORT
+#define OTA_PORT 8080
+#endif
+#ifndef OTA_PATH
+#define OTA_PATH "/firmware/" DEVICE_NAME ".bin"
+#endif
+#ifndef OTA_FIRST_CHECK_MS
+#define OTA_FIRST_CHECK_MS 60000       // first check after boot, once the first readings are in
+#endif
+#ifndef OTA_CHECK_MS
+#define OTA_CHECK_MS 21600000          // interval between two checks (6 hours)
+#endif
+#ifndef OTA_CHUNK
+#define OTA_CHUNK 4096                 // bytes received and written per step, one flash sector
+#endif
+#ifndef OTA_CHUNK_PAUSE_MS
+#define OTA_CHUNK_PAUSE_MS 20          // pause after every chunk, the flash and caches go back to the other tasks
+#endif
+#ifndef OTA_TIMEOUT_MS
+#define OTA_TIMEOUT_MS 10000           // Wi-Fi association and receive timeout
+#endif
+#ifndef OTA_TASK_STACK
+#define OTA_TASK_STACK 4096            // download task stack size in bytes (the chunk buffer is static)
+#endif
+
+// ESP-NOW fleet mesh
+#define MESH_OFF 0                     // standalone unit
+#define MESH_LEAF 1                    // broadcast readings, no Wi-Fi association
+#define MESH_AGGREGATOR 2              // collect the fleet, the only unit with a Wi-Fi uplink
+#ifndef MESH_ROLE
+#define MESH_ROLE MESH_OFF
+#endif
+#ifndef MESH_CHANNEL
+#define MESH_CHANNEL 1                 // Wi-Fi channel of the mesh (the access point's, on an uplinked aggregator)
+#endif
+#ifndef MESH_REPEATS
+#define MESH_REPEATS 2                 // copies of every frame (broadcasts are not acknowledged)
+#endif
+#ifndef MESH_SEND_TIMEOUT_MS
+#define MESH_SEND_TIMEOUT_MS 20        // longest wait for the send callback of one copy
+#endif
+#ifndef MESH_QUEUE
+#define MESH_QUEUE 32                  // frames buffered between the radio and the consuming task (power of two)
+#endif
+#ifndef MESH_MAX_NODES
+#define MESH_MAX_NODES 64              // (node, sensor) pairs tracked by the aggregator
+#endif
+#ifndef MESH_NODE_TIMEOUT_MS
+#define MESH_NODE_TIMEOUT_MS 90000     // a pair is offline after this long without a frame
+#endif
+#ifndef MESH_SEQUENCE_WINDOW
+#define MESH_SEQUENCE_WINDOW 64        // sequence numbers this far back count as repeats, older as a reboot
+#endif
+#ifndef MESH_VIEW_MS
+#define MESH_VIEW_MS 1000              // shortest interval between two fleet view redraws
+#endif
+#ifndef MESH_TASK_STACK
+#define MESH_TASK_STACK 3072           // leaf send task stack size in bytes
+#endif
+
+// Threshold alarms (see Alarm.h), limits in tenths like the samples
+#ifndef ALARMS
+#define ALARMS 0                       // 1 = evaluate every reading in the sensor task as it lands
+#endif
+#ifndef ALARM_PIN
+#define ALARM_PIN -1                   // alarm output (buzzer, relay, LED on a free GPIO), -1 = screen only
+#endif
+#ifndef ALARM_ACTIVE_HIGH
+#define ALARM_ACTIVE_HIGH 1            // level of ALARM_PIN while an alarm is active
+#endif
+#ifndef ALARM_T_HIGH
+#define ALARM_T_HIGH 350               // °C x 10
+#endif
+#ifndef ALARM_T_LOW
+#define ALARM_T_LOW 50                 // °C x 10
+#endif
+#ifndef ALARM_RH_HIGH
+#define ALARM_RH_HIGH 800              // % x 10
+#endif
+#ifndef ALARM_RH_LOW
+#define ALARM_RH_LOW 200               // % x 10
+#endif
+#ifndef ALARM_HYSTERESIS_T
+#define ALARM_HYSTERESIS_T 5           // a level alarm clears this far back inside its limit
+#endif
+#ifndef ALARM_HYSTERESIS_RH
+#define ALARM_HYSTERESIS_RH 20
+#endif
+#ifndef ALARM_RATE_T
+#define ALARM_RATE_T 30                // °C x 10 per minute, 0 = no rate alarm
+#endif
+#ifndef ALARM_RATE_RH
+#define ALARM_RATE_RH 150              // % x 10 per minute, 0 = no rate alarm
+#endif
+#ifndef ALARM_RATE_WINDOW_MS
+#define ALARM_RATE_WINDOW_MS 20000     // shortest span a rate is measured over (longer than the noise)
+#endif
+#ifndef ALARM_QUEUE
+#define ALARM_QUEUE 16                 // alarm events buffered between the sensor task and loop() (power of two)
+#endif
+#ifndef ALARM_SCREEN_BUDGET_MS
+#define ALARM_SCREEN_BUDGET_MS 50      // sample-to-alert-on-screen budget, misses are counted
+#endif
+
+// Trend graph
+#ifndef GRAPH_SPAN_MINUTES
+#define GRAPH_SPAN_MINUTES 10 // time shown across the width of the graph
+#endif
+#ifndef GRAPH_T_MIN
+#define GRAPH_T_MIN 0         // bottom of the temperature axis in °C x 10
+#endif
+#ifndef GRAPH_T_MAX
+#define GRAPH_T_MAX 500       // top of the temperature axis in °C x 10
+#endif
+#ifndef GRAPH_RH_MIN
+#define GRAPH_RH_MIN 200      // bottom of the humidity axis in % x 10
+#endif
+#ifndef GRAPH_RH_MAX
+#define GRAPH_RH_MAX 900      // top of the humidity axis in % x 10
+#endif
+
+// Pages (see Pages.h), button 1 steps through live values, trend, min/max and diagnostics
+#ifndef PAGE_TREND_SPAN_MINUTES
+#define PAGE_TREND_SPAN_MINUTES 60   // time shown across the trend page
+#endif
+#ifndef PAGE_STATS_RECENT_WINDOWS
+#define PAGE_STATS_RECENT_WINDOWS 16 // history windows (HISTORY_WINDOW samples each) in the "Recent" column
+#endif
+
+// Scheduler mode
+//  SCHEDULER_BLOCKING    = tasks block between deadlines, the idle task clock-gates the CPU (waiti)
+//  SCHEDULER_LIGHT_SLEEP = as above, plus automatic light sleep and frequency scaling through esp_pm
+//                          (needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE in sdkconfig)
+#define SCHEDULER_BLOCKING    0
+#define SCHEDULER_LIGHT_SLEEP 1
+#ifndef SCHEDULER_MODE
+#define SCHEDULER_MODE SCHEDULER_BLOCKING
+#endif
+#ifndef PM_MAX_FREQ_MHZ
+#define PM_MAX_FREQ_MHZ 240 // CPU frequency while busy (light sleep mode)
+#endif
+#ifndef PM_MIN_FREQ_MHZ
+#define PM_MIN_FREQ_MHZ 40  // CPU frequency while idle (light sleep mode)
+#endif
+
+// Deep-sleep logging mode
+//  1 = take one reading per wake, keep it in RTC memory and deep-sleep until the next reading; the
+//      display only comes up every DEEP_SLEEP_FLUSH_EVERY samples to flush the batch
+//  0 = always-on loop()
+#ifndef DEEP_SLEEP_LOGGER
+#define DEEP_SLEEP_LOGGER 0
+#endif
+#ifndef DEEP_SLEEP_BUFFER_SIZE
+#define DEEP_SLEEP_BUFFER_SIZE 128 // samples kept in RTC memory (8 bytes each)
+#endif
+#ifndef DEEP_SLEEP_FLUSH_EVERY
+#define DEEP_SLEEP_FLUSH_EVERY 30  // samples per flush (30 x 2 s = one flush a minute)
+#endif
+
+// Screen orientation (see Layout.h)
+#define ORIENTATION_PORTRAIT  0 // 170 x 320, trend graph below the values
+#define ORIENTATION_LANDSCAPE 1 // 320 x 170, trend graph right of the values
+#ifndef DISPLAY_ORIENTATION
+#define DISPLAY_ORIENTATION ORIENTATION_PORTRAIT
+#endif
+
+// Dynamic field rendering mode
+//  1 = each dynamic field is drawn into its own off-screen sprite and pushed as a single block
+//  0 = fields are cleared and printed directly on the screen
+#ifndef USE_SPRITE_FIELDS
+#define USE_SPRITE_FIELDS 1
+#endif
+
+// Buttons (active low, see Buttons.h)
+#ifndef BUTTON_1_PIN
+#define BUTTON_1_PIN 0           // BOOT button
+#endif
+#ifndef BUTTON_2_PIN
+#define BUTTON_2_PIN 14
+#endif
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 50    // edges closer than this to the previous press are ignored
+#endif
+
+// Loop profiler (see Profiler.h)
+//  1 = time every state of the loop() state machine, report on serial and in an overlay (button 2)
+//  0 = no instrumentation
+#ifndef PROFILER
+#define PROFILER 1
+#endif
+#ifndef PROFILER_REPORT_MS
+#define PROFILER_REPORT_MS 10000 // serial report period, 0 = overlay only
+#endif
+#ifndef PROFILER_OVERLAY_MS
+#define PROFILER_OVERLAY_MS 1000 // overlay refresh period while it is shown
+#endif
+#ifndef PROFILER_RATE_WINDOW_MS
+#define PROFILER_RATE_WINDOW_MS 60000 // loop rate window, several sample intervals long
+#endif
+
+// Diagnostics (see Diagnostics.h)
+//  1 = heap, PSRAM, stack and energy figures on a page (see Pages.h) and on serial ("diag")
+//  0 = not built
+#ifndef DIAGNOSTICS
+#define DIAGNOSTICS 1
+#endif
+#ifndef DIAG_PAGE_MS
+#define DIAG_PAGE_MS 1000              // page refresh period while it is shown
+#endif
+#ifndef DIAG_CURRENT_BASE_UA
+#define DIAG_CURRENT_BASE_UA 45000     // board with the CPU mostly idle and the backlight off, in µA
+#endif
+#ifndef DIAG_CURRENT_BACKLIGHT_UA
+#define DIAG_CURRENT_BACKLIGHT_UA 60000 // extra draw of the backlight at BACKLIGHT_FULL, in µA
+#endif
+#ifndef DIAG_CURRENT_RADIO_UA
+#define DIAG_CURRENT_RADIO_UA 70000    // extra draw while the radio is on, in µA
+#endif
+
+// Benchmark harness ([env:bench], see src/bench/Bench.cpp)
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS 1000 // iterations per display benchmark, formatting runs 10x as many
+#endif
+#ifndef BENCH_DHT_READS
+#define BENCH_DHT_READS 20    // timed sensor reads, SENSOR_READ_INTERVAL_MS apart
+#endif
+
+// Display push pipeline (see DisplayPush.h)
+//  1 = sprite pushes run in the background (DMA if the bus has it, else a display task on core 0)
+//  0 = sprites are pushed synchronously from loop()
+#ifndef DISPLAY_ASYNC_PUSH
+#define DISPLAY_ASYNC_PUSH 1
+#endif
+#ifndef DISPLAY_PUSH_QUEUE
+#define DISPLAY_PUSH_QUEUE 8        // queued window pushes (power of two)
+#endif
+#ifndef DISPLAY_TASK_CORE
+#define DISPLAY_TASK_CORE 0         // the other core than loop()
+#endif
+#ifndef DISPLAY_TASK_PRIORITY
+#define DISPLAY_TASK_PRIORITY 2     // below the sensor task, so reads still start on time
+#endif
+#ifndef DISPLAY_TASK_STACK
+#define DISPLAY_TASK_STACK 3072     // display task stack size in bytes
+#endif
+
+// Display power management (see DisplayPower.h)
+#ifndef BACKLIGHT_LEDC_CHANNEL
+#define BACKLIGHT_LEDC_CHANNEL 0     // LEDC channel driving TFT_BL (Arduino-ESP32 2.x API)
+#endif
+#ifndef BACKLIGHT_PWM_FREQ
+#define BACKLIGHT_PWM_FREQ 10000     // Hz, well above visible flicker
+#endif
+#ifndef BACKLIGHT_FULL
+#define BACKLIGHT_FULL 255           // duty while active (0-255)
+#endif
+#ifndef BACKLIGHT_DIM
+#define BACKLIGHT_DIM 24             // duty after BACKLIGHT_DIM_MS without activity
+#endif
+#ifndef BACKLIGHT_DIM_MS
+#define BACKLIGHT_DIM_MS 30000       // idle time before dimming, 0 = never dim
+#endif
+#ifndef DISPLAY_SLEEP_MS
+#define DISPLAY_SLEEP_MS 120000      // idle time before the panel sleeps, 0 = never sleep
+#endif
+#ifndef WAKE_DELTA_T
+#define WAKE_DELTA_T 10              // °C x 10 move since the last significant change that wakes the display
+#endif
+#ifndef WAKE_DELTA_RH
+#define WAKE_DELTA_RH 50             // % x 10 move since the last significant change that wakes the display
+#endif
+
+// Static frame cache (see StaticFrame.h)
+//  1 = the static text is blitted from a 1-bit image cached in flash (NVS)
+//  0 = the static text is drawn glyph by glyph on every redraw
+#ifndef STATIC_FRAME_CACHE
+#define STATIC_FRAME_CACHE 1
+#endif
@@ -0,0 +1,32 @@
+/*********************************************************************************************************
+ * Derived Metrics
+ *
+ * Description:
+ *   Dew point, heat index and absolute humidity from one temperature/humidity pair, in the same
+ *    fixed-point tenths as the raw readings. Nothing here calls logf/expf:
+ *   - Dew point and absolute humidity come from a 1 °C table of the saturation vapour pressure over
+ *      water (Magnus, 6.112 hPa * e^(17.62 T / (243.12 + T)), -40..80 °C) with linear interpolation.
+ *      The dew point is the inverse lookup of the actual vapour pressure in the same table, so at
+ *      100 % it equals the temperature exactly.
+ *   - Heat index is the NWS formula (Rothfusz regression with its low/high humidity adjustments,
+ *      Steadman's simple formula below 80 °F) evaluated with 64-bit integers.
+ *   The stage is meant to run after the median/deadband filter, so it is only evaluated when a
+ *    reading the display shows actually changed.
+ *
+ * Notes:
+ *   - Interpolation error is below 0.1 °C / 0.1 g/m³ over the table range; outside it the temperature
+ *      is clamped.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+struct DerivedSample {
+  int16_t dewPoint_decidegC;     // dew point in °C x 10
+  int16_t heatIndex_decidegC;    // apparent temperature in °C x 10
+  uint16_t absHumidity_decigm3;  // water vapour density in g/m³ x 10
+};
+
+// Derive the metrics of one reading (temperature in °C x 10, relative humidity in % x 10)
+DerivedSample deriveMetrics(int16_t t_decidegC, uint16_t rh_decipct);
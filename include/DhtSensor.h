@@ -0,0 +1,125 @@
+/*********************************************************************************************************
+ * DHT Sensor Driver
+ *
+ * Description:
+ *   Non-blocking interface to a DHT11/DHT22 sensor. A read is started with startRead() and then
+ *    polled with poll() until it reports a result, so the caller never stalls while the sensor
+ *    transmits its 40-bit frame. Each completed read is one bus transaction and yields one
+ *    SensorSample, with temperature and humidity decoded from the same frame.
+ *
+ * Backends (selected with DHT_BACKEND in Config.h):
+ *   - RMT:      the start pulse is timed by an esp_timer and the frame is captured by the RMT
+ *                peripheral, so the CPU only decodes the finished pulse train.
+ *   - Adafruit: startRead() performs the blocking Adafruit DHT read and poll() returns its result.
+ *
+ * Sensor Profiles:
+ *   Everything that differs between DHT11 and DHT22 (start pulse, minimum read interval, frame
+ *    decoding) lives in a DhtTraits specialization. dhtProfile() picks the traits at compile time and
+ *    a sensor is constructed from the resulting DhtProfile, so the driver has no type branches.
+ *
+ * Disconnect Detection (DHT_LINE_CHECK):
+ *   Before the start pulse the pin's pull-down is enabled for a few microseconds. A connected module
+ *    holds the line high through its pull-up resistor, an open line drops low, in which case the read
+ *    fails at once with NOT_CONNECTED instead of waiting out the frame timeout.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SensorSample.h"
+
+// Supported sensor types
+enum class DhtType : uint8_t {
+  Dht11 = 11,
+  Dht22 = 22
+};
+
+// Compile-time description of one sensor type
+template <DhtType Type>
+struct DhtTraits;
+
+template <>
+struct DhtTraits<DhtType::Dht11> {
+  static constexpr const char *name = "DHT11";
+  static constexpr uint32_t startPulseUs = 20000; // at least 18 ms
+  static constexpr uint32_t minIntervalMs = 1000; // sampling period per datasheet
+
+  // Integer and decimal bytes
+  static void decode(const uint8_t *frame, SensorSample &sample) {
+    sample.rh_decipct = frame[0] * 10 + frame[1] % 10;
+    int16_t temperature = frame[2] * 10 + (frame[3] & 0x0F) % 10;
+    sample.t_decidegC = (frame[3] & 0x80) ? -temperature : temperature; // below zero flag
+  }
+};
+
+template <>
+struct DhtTraits<DhtType::Dht22> {
+  static constexpr const char *name = "DHT22";
+  static constexpr uint32_t startPulseUs = 1100;  // at least 1 ms
+  static constexpr uint32_t minIntervalMs = 2000; // sampling period per datasheet
+
+  // 16-bit values already in tenths
+  static void decode(const uint8_t *frame, SensorSample &sample) {
+    sample.rh_decipct = (frame[0] << 8) | frame[1];
+    int16_t temperature = ((frame[2] & 0x7F) << 8) | frame[3];
+    sample.t_decidegC = (frame[2] & 0x80) ? -temperature : temperature; // below zero flag
+  }
+};
+
+// Traits of a sensor type as plain data, filled in at compile time by dhtProfile()
+struct DhtProfile {
+  DhtType type;
+  const char *name;
+  uint32_t startPulseUs;
+  uint32_t minIntervalMs;
+  void (*decode)(const uint8_t *frame, SensorSample &sample);
+};
+
+template <DhtType Type>
+constexpr DhtProfile dhtProfileOf() {
+  return { Type, DhtTraits<Type>::name, DhtTraits<Type>::startPulseUs, DhtTraits<Type>::minIntervalMs,
+           &DhtTraits<Type>::decode };
+}
+
+constexpr DhtProfile dhtProfile(DhtType type) {
+  return type == DhtType::Dht11 ? dhtProfileOf<DhtType::Dht11>() : dhtProfileOf<DhtType::Dht22>();
+}
+
+class DhtSensor {
+public:
+  // Result of a read
+  enum class Status : uint8_t {
+    IDLE,           // no read has been started yet
+    BUSY,           // start pulse or frame capture in progress
+    OK,             // frame received and checksum valid
+    TIMEOUT,        // sensor did not answer in time
+    CHECKSUM_ERROR, // frame received but corrupted
+    NOT_CONNECTED   // line check failed, reported at once without sending a start pulse
+  };
+
+  DhtSensor(uint8_t pin, const DhtProfile &profile);
+
+  void begin();      // configure the pin and the backend
+  bool startRead();  // send the start pulse, returns false if a read is already in progress
+  Status poll();     // check on the current read, never blocks
+
+  const SensorSample &sample() const { return _sample; } // result of the last completed read
+  const DhtProfile &profile() const { return _profile; }
+
+private:
+  static void onStartPulseDone(void *arg); // releases the line and arms the capture (RMT backend)
+  bool lineConnected();                    // quick level check of the data line before a start pulse
+  bool decodeFrame();                      // checksum and convert _data into _sample
+  void finishRead(Status status);          // record the outcome of the transaction in _sample
+
+  uint8_t _pin;
+  DhtProfile _profile;
+  volatile Status _status = Status::IDLE;
+  SensorSample _sample = {0, 0, 0, SampleStatus::TIMEOUT, 0};
+  uint8_t _data[5] = {};            // raw 40-bit frame
+  void *_driver = nullptr;          // backend handle (RMT ring buffer or Adafruit DHT instance)
+  void *_timer = nullptr;           // start pulse timer (RMT backend)
+  volatile bool _captureArmed = false;
+  volatile int64_t _captureStartedAt = 0;
+};
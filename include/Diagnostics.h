@@ -0,0 +1,63 @@
+/*********************************************************************************************************
+ * Diagnostics
+ *
+ * Description:
+ *   Memory and energy picture of a running unit (DIAGNOSTICS): free heap, its low-water mark and
+ *    largest free block, PSRAM use, the stack high-water mark of every task of the project, radio
+ *    on-time, backlight on-time, and the charge drawn since boot with the average current (mAh per
+ *    hour) estimated from them.
+ *   Every figure comes from a counter that is kept up as it happens (heap statistics of the allocator,
+ *    FreeRTOS stack watermarks, the on-time totals of WifiLink, Mesh and DisplayPower), so taking a
+ *    snapshot costs the same at any uptime.
+ *
+ * Output:
+ *   - Screen: the diagnostics page (Pages.h), refreshed every DIAG_PAGE_MS while it is shown.
+ *   - Serial: "diag" followed by a newline prints a report (with OTA_UPDATE, also the firmware download).
+ *
+ * Notes:
+ *   - The charge is a model, not a measurement: DIAG_CURRENT_BASE_UA for the time up, plus
+ *      DIAG_CURRENT_BACKLIGHT_UA scaled by the PWM duty for the backlight on-time, plus
+ *      DIAG_CURRENT_RADIO_UA for the radio on-time. Calibrate the three with a meter once per board.
+ *   - Stack watermarks are the fewest bytes ever left free on a task's stack.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "Config.h"
+
+const uint8_t diagTaskCount = 7; // tasks whose stacks are watched (loop, sensor, display, uplink, metrics, mesh, ota)
+
+// Stack watermark of one task
+struct TaskStack {
+  const char *name;
+  bool running;       // false if the task does not exist in this build
+  uint32_t freeBytes; // fewest bytes ever left free
+};
+
+// One reading of every diagnostics figure
+struct DiagnosticsSnapshot {
+  uint32_t uptimeMs;
+  uint32_t freeHeap;         // internal RAM, bytes
+  uint32_t minFreeHeap;      // lowest free heap since boot
+  uint32_t largestFreeBlock; // largest single allocation that would succeed
+  uint32_t psramSize;        // 0 without PSRAM
+  uint32_t psramFree;
+  TaskStack tasks[diagTaskCount];
+  uint32_t radioOnMs;        // Wi-Fi association plus ESP-NOW radio time
+  uint32_t backlightOnMs;    // at BACKLIGHT_FULL
+  uint32_t backlightDimMs;   // at BACKLIGHT_DIM
+  uint32_t charge_decimAh;   // estimated charge since boot in mAh x 10
+  uint32_t current_uA;       // estimated average current in µA (mAh per hour x 1000)
+};
+
+void diagnosticsBegin();                     // listen for serial commands, the calling task is woken on input
+void diagnosticsPollSerial();                // handle the complete command lines received so far
+DiagnosticsSnapshot diagnosticsSnapshot();
+void diagnosticsReport(Print &out);          // a few lines, prefixed "diag,"
+
+void drawDiagnosticsBackground(TFT_eSPI &canvas); // page title and labels, into the page sprite (Pages.h)
+void invalidateDiagnosticsPage();            // the background was drawn, every value is drawn again
+bool diagnosticsPageDirty();                 // true if the shown page is due for a refresh
+void drawDiagnosticsPage();                  // draw the values that changed
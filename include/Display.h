@@ -0,0 +1,40 @@
+/*********************************************************************************************************
+ * Display
+ *
+ * Description:
+ *   Owns the TFT_eSPI instance and the screen layout. The dynamic part of the screen is a set of
+ *    text fields, each with a dirty bit and a cached copy of the text currently on the panel.
+ *    setField() only marks a field dirty when its text actually changes, and updateDynamicElements()
+ *    only pushes the glyphs from the first changed character onwards, so the cost of an update
+ *    scales with what changed rather than with what is on screen.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "Config.h"
+#include "DerivedMetrics.h"
+#include "SensorSample.h"
+
+extern TFT_eSPI tft;
+
+// Dynamic fields on the screen (new fields go before COUNT)
+enum class DisplayField : uint8_t {
+  STATUS,
+  TEMPERATURE,
+  HUMIDITY,
+  DERIVED,     // dew point / heat index
+  COUNT
+};
+
+void initDisplay();                                 // init the panel and the field buffers
+void drawStaticElements();                          // draw the labels and clear every field cache
+void drawLiveBackground(TFT_eSPI &canvas);          // labels and graph legend, into a page sprite (Pages.h)
+void invalidateLiveScreen();                        // the background was redrawn, every field and the
+                                                    //  graph are drawn again on the next update
+void setField(DisplayField field, const char *text); // set a field's text, marks it dirty if it changed
+void showSample(const SensorSample &sample);        // format a sample into its fields (or sensor table row)
+void showDerived(const DerivedSample &derived);     // format the derived metrics of the displayed sample
+bool displayDirty();                                // true if any field needs pushing
+void updateDynamicElements();                       // push the changed part of every dirty field
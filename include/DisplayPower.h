@@ -0,0 +1,37 @@
+/*********************************************************************************************************
+ * Display Power
+ *
+ * Description:
+ *   Activity-driven power management of the panel, whose backlight is the largest current draw on the
+ *    board. The backlight is driven by an LEDC PWM channel instead of being switched fully on:
+ *    - active:  BACKLIGHT_FULL brightness
+ *    - idle for BACKLIGHT_DIM_MS:   dimmed to BACKLIGHT_DIM
+ *    - idle for DISPLAY_SLEEP_MS:   backlight off and the ST7789 in sleep mode (SLPIN)
+ *   displayActivity() (a button press, a significant reading change) returns to full brightness and
+ *    wakes the panel (SLPOUT) if it was asleep.
+ *
+ * Notes:
+ *   - The panel keeps its frame memory while asleep. Dynamic fields stay dirty until it wakes and
+ *      are pushed in one go then, so nothing is transferred to a dark screen.
+ *   - A time of 0 disables the respective step.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Panel power states
+enum class DisplayPowerState : uint8_t {
+  ON,     // full brightness
+  DIMMED, // reduced brightness
+  ASLEEP  // backlight off, panel in sleep mode
+};
+
+void displayPowerBegin();                 // take the backlight pin over with the PWM channel
+void displayActivity();                   // restart the idle timer, wake and brighten the panel
+void updateDisplayPower();                // apply the dim/sleep steps that are due
+bool displayAwake();                      // false while the panel sleeps
+DisplayPowerState displayPowerState();
+uint32_t displayPowerTimeoutMs();         // time until the next step is due, UINT32_MAX if none
+uint32_t displayStateTimeMs(DisplayPowerState state); // total time spent in a state since boot
@@ -0,0 +1,28 @@
+/*********************************************************************************************************
+ * Display Push Pipeline
+ *
+ * Description:
+ *   Moves the sprite-to-panel transfers off the loop task, so the CPU work of the next frame (sample
+ *    filtering, history, telemetry packing, rendering into sprites) overlaps the bus transfer of the
+ *    current one.
+ *   - With a DMA capable bus (TFT_eSPI defines ESP32_DMA, SPI panels) a push is started with
+ *      pushImageDMA() and the bus runs on its own.
+ *   - The T-Display-S3 panel sits on the 8-bit parallel bus, which TFT_eSPI drives from the CPU
+ *      without DMA. There the pushes run in a display task on core 0, leaving core 1 to the loop.
+ *
+ * Fences:
+ *   - waitForSprite() before drawing into a sprite that may still be in flight.
+ *   - displayFence() before any direct tft call, and before the panel is put to sleep.
+ *   With DISPLAY_ASYNC_PUSH = 0 every push is synchronous and both fences return at once.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+#include "Config.h"
+
+void displayPushBegin();                    // start the display task / DMA channel
+void queueSpritePush(TFT_eSprite &sprite, int16_t tx, int16_t ty, int16_t sx, int16_t sy, int16_t sw,
+                     int16_t sh);           // push a window of a sprite (same arguments as pushSprite)
+void waitForSprite(const TFT_eSprite &sprite); // block until no queued push reads from the sprite
+void displayFence();                        // block until every queued push reached the panel
@@ -0,0 +1,57 @@
+/*********************************************************************************************************
+ * Fixed-Point Formatting
+ *
+ * Description:
+ *   Allocation-free text rendering for the display path. Values are passed as integers in tenths
+ *    (the 0.1 resolution of the DHT sensors) and written into a caller-provided stack buffer, so a
+ *    redraw never touches the heap.
+ *
+ * Example:
+ *   DeciText text;
+ *   formatDeci(text, 235, 'C'); // "23.5 C"
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Buffer sized for the widest possible result: the most negative tenths value, plus unit and NUL
+constexpr size_t deciTextSize = sizeof("-3276.8 C");
+typedef char DeciText[deciTextSize];
+
+// Two values joined as "<a> / <b>" (each without its NUL, plus the separator and one NUL)
+constexpr size_t deciPairTextSize = 2 * (deciTextSize - 1) + sizeof(" / ");
+
+// Render a value in tenths as "<int>.<tenth> <unit>" (no unit if unit is 0), returns the text length
+inline size_t formatDeci(DeciText &out, int16_t tenths, char unit = 0) {
+  char *p = out;
+  int32_t value = tenths; // widen so the most negative value can be negated
+
+  if (value < 0) {
+    *p++ = '-';
+    value = -value;
+  }
+
+  // Integer part, written backwards into a scratch buffer
+  char digits[5];
+  uint8_t count = 0;
+  int32_t whole = value / 10;
+  do {
+    digits[count++] = static_cast<char>('0' + whole % 10);
+    whole /= 10;
+  } while (whole > 0);
+  while (count > 0) {
+    *p++ = digits[--count];
+  }
+
+  // Tenths and unit
+  *p++ = '.';
+  *p++ = static_cast<char>('0' + value % 10);
+  if (unit != 0) {
+    *p++ = ' ';
+    *p++ = unit;
+  }
+  *p = '\0';
+  return static_cast<size_t>(p - out);
+}
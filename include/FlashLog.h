@@ -0,0 +1,46 @@
+/*********************************************************************************************************
+ * Flash Log
+ *
+ * Description:
+ *   Power-loss tolerant sample log on the LittleFS partition. Samples are packed into compact binary
+ *    records and collected in a RAM page buffer; only full pages (LOG_PAGE_SIZE bytes, one flash
+ *    program page) are appended to the log file, which is kept open so LittleFS keeps filling its
+ *    current block instead of copying it. LittleFS spreads the block erases over the partition.
+ *
+ * Record Format (little endian):
+ *   - Key record,   9 bytes: 0xFF, uint32 seconds, int16 temperature x 10, uint16 humidity x 10
+ *   - Delta record, 3 bytes: uint8 seconds since the previous record (1..254), int8 temperature delta,
+ *                             int8 humidity delta
+ *   - Padding,      0x00 up to the end of the page
+ *   Every page starts with a key record, so each page decodes on its own.
+ *
+ * Notes:
+ *   - At most one partly filled page (LOG_PAGE_SIZE / 3 samples) is lost on a power cut.
+ *   - When the log reaches LOG_MAX_BYTES it is renamed to the backup file, replacing the previous one.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+class FlashLog {
+public:
+  bool begin();                                                 // mount LittleFS and open the log
+  void append(uint32_t seconds, int16_t t_decidegC, uint16_t rh_decipct); // add one sample
+  void flush();                                                 // write the partly filled page now
+  void dump(Print &out);                                        // decode the log as CSV
+
+private:
+  void appendRecord(const uint8_t *record, uint8_t length);
+  void writePage();
+
+  uint8_t _page[LOG_PAGE_SIZE];
+  uint16_t _used = 0;          // bytes used in _page
+  bool _mounted = false;
+  uint32_t _lastSeconds = 0;   // values of the previous record in this page
+  int16_t _lastT = 0;
+  uint16_t _lastRh = 0;
+};
+
+extern FlashLog flashLog;
@@ -0,0 +1,18 @@
+/*********************************************************************************************************
+ * Fleet View
+ *
+ * Description:
+ *   Fleet summary of a mesh aggregator (MESH_ROLE == MESH_AGGREGATOR), drawn in place of the trend
+ *    graph: how many (node, sensor) pairs are online, min/mean/max temperature and humidity over them,
+ *    and one line per pair for as many pairs as fit. It is redrawn at most every MESH_VIEW_MS, and only
+ *    when a new reading arrived (or every few seconds, so ages and offline pairs stay current).
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+void invalidateFleetView(); // the area was cleared, draw it again on the next update
+bool fleetViewDirty();      // true if the view needs a redraw
+void drawFleetView();       // draw the view over the trend graph area
@@ -0,0 +1,103 @@
+/*********************************************************************************************************
+ * Sample History
+ *
+ * Description:
+ *   Fixed-capacity time series of valid samples. Samples are stored packed as a structure of arrays
+ *    (temperature, humidity and a 16-bit time offset, 6 bytes per sample), so a scan over one channel
+ *    walks a single contiguous array.
+ *
+ * Storage Tiers:
+ *   - Hot:  the most recent HISTORY_HOT_SAMPLES samples, in internal SRAM.
+ *   - Cold: older samples, HISTORY_COLD_SAMPLES of them in PSRAM. Whenever the hot ring fills, its
+ *            oldest window is spilled to the cold ring with one copy per column.
+ *
+ * Aggregates:
+ *   Samples are grouped into windows of HISTORY_WINDOW samples. Each window keeps its min/max/sum,
+ *    updated as samples are appended, so a query over any span of history only combines per-window
+ *    aggregates and never rescans the raw samples.
+ *
+ * Notes:
+ *   - Samples are indexed by sequence number (0 for the first sample ever appended); only the range
+ *      firstIndex() .. endIndex() - 1 is still held. After a gap of over 18 hours the rest of the
+ *      window is skipped: get() is false for those sequence numbers, and size() still counts them.
+ *   - append() and the queries are meant to be called from the same task. Another task (the metrics
+ *      server) may read too, but only between lock() and unlock(); append() takes the lock itself, so
+ *      a reader holding it for one short batch of get() calls never sees a ring slot being reused.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "Config.h"
+#include "SensorSample.h"
+
+// One stored sample
+struct HistorySample {
+  int16_t t_decidegC;  // temperature in °C x 10
+  uint16_t rh_decipct; // relative humidity in % x 10
+  uint32_t ts;         // seconds since boot
+};
+
+// Running min/max/sum over a span of samples
+struct HistoryAggregate {
+  uint32_t startTs = 0;   // time of the first sample (seconds since boot)
+  uint32_t endTs = 0;     // time of the last sample
+  uint32_t count = 0;     // samples in the span
+  int16_t tMin = 0;
+  int16_t tMax = 0;
+  int32_t tSum = 0;
+  uint16_t rhMin = 0;
+  uint16_t rhMax = 0;
+  uint32_t rhSum = 0;
+
+  void add(int16_t t, uint16_t rh, uint32_t ts);  // O(1) update with one sample
+  void merge(const HistoryAggregate &other);       // O(1) combine with a later span
+  int16_t tMean() const { return count ? tSum / (int32_t)count : 0; }
+  uint16_t rhMean() const { return count ? rhSum / count : 0; }
+};
+
+class History {
+public:
+  bool begin();                                     // allocate the cold tier, false if it stayed hot-only
+  void append(const SensorSample &sample);          // store a sample (invalid samples are ignored)
+
+  uint32_t firstIndex() const;                      // sequence number of the oldest sample held
+  uint32_t endIndex() const { return _end; }        // sequence number after the newest sample
+  uint32_t size() const { return _end - firstIndex(); }
+  bool get(uint32_t index, HistorySample &out) const; // read one sample, false if no longer held
+
+  // Aggregate of the newest windows (the current, partly filled window counts as one)
+  HistoryAggregate summarize(uint32_t windows) const;
+
+  // Exclusive access for readers on other tasks (keep it short, append() waits for it)
+  void lock() const;
+  void unlock() const;
+
+private:
+  uint32_t windowSlot(uint32_t index) const { return (index / HISTORY_WINDOW) % _windowCapacity; }
+  void spillOldestWindow();
+
+  // Hot tier, internal SRAM
+  int16_t _hotT[HISTORY_HOT_SAMPLES];
+  uint16_t _hotRh[HISTORY_HOT_SAMPLES];
+  uint16_t _hotTs[HISTORY_HOT_SAMPLES];   // seconds since the start of the sample's window
+
+  // Cold tier, PSRAM
+  int16_t *_coldT = nullptr;
+  uint16_t *_coldRh = nullptr;
+  uint16_t *_coldTs = nullptr;
+  uint32_t _coldCapacity = 0;
+
+  // Per-window aggregates, covering both tiers
+  HistoryAggregate *_windows = nullptr;
+  uint32_t _windowCapacity = 0;          // 0 until begin() allocated the aggregates, append() drops samples
+
+  uint32_t _hotStart = 0; // sequence number of the oldest hot sample (window aligned)
+  uint32_t _end = 0;      // sequence number of the next sample
+
+  SemaphoreHandle_t _mutex = nullptr; // guards the rings against readers on other tasks
+};
+
+extern History history;
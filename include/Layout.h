@@ -0,0 +1,127 @@
+/*********************************************************************************************************
+ * Screen Layout
+ *
+ * Description:
+ *   Compile-time description of the screen for each panel orientation. LayoutFor<> holds the few
+ *    numbers that define a variant; LayoutOf<> derives every label position, field rectangle (its
+ *    width is also the clear/sprite width) and table cell from them as constexpr values, and checks
+ *    with static_assert that everything fits the panel.
+ *   The variant is picked with DISPLAY_ORIENTATION, so each build only contains the code of its own
+ *    layout and none of its positions are computed at run time.
+ *
+ * Regions (portrait / landscape):
+ *   - Title:  three lines at the top, full width
+ *   - Values: status/temperature/humidity/derived labels with their fields below them (or the sensor table)
+ *   - Graph:  trend graph legend and graph below the values / right of the values
+ *   - Pages:  title line, then the trend plot or the text lines of the other pages (Pages.h)
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "Config.h"
+
+// Screen rectangle
+struct Rect {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+
+  constexpr int16_t right() const { return x + w; }
+  constexpr int16_t bottom() const { return y + h; }
+};
+
+template <uint8_t Orientation>
+struct LayoutFor;
+
+// 170 x 320, trend graph below the values
+template <>
+struct LayoutFor<ORIENTATION_PORTRAIT> {
+  static constexpr uint8_t rotation = 0;
+  static constexpr int16_t width = 170;
+  static constexpr int16_t height = 320;
+  static constexpr int16_t firstLabelY = 54;      // "Status:"
+  static constexpr int16_t labelPitch = 38;       // label to label
+  static constexpr int16_t labelToField = 16;     // label to the field below it
+  static constexpr int16_t valueWidth = width;    // width of the value column
+  static constexpr int16_t tableY = 54;           // sensor table column titles
+  static constexpr int16_t tableHumidityX = 100;
+  static constexpr int16_t staticFrameHeight = 208; // everything above the graph legend
+  static constexpr Rect legend = { 0, 210, width, 8 };
+  static constexpr Rect graph = { 0, 220, width, height - 220 };
+};
+
+// 320 x 170, trend graph right of the values
+template <>
+struct LayoutFor<ORIENTATION_LANDSCAPE> {
+  static constexpr uint8_t rotation = 1;
+  static constexpr int16_t width = 320;
+  static constexpr int16_t height = 170;
+  static constexpr int16_t firstLabelY = 50;
+  static constexpr int16_t labelPitch = 29;
+  static constexpr int16_t labelToField = 15;     // the blank bottom row of the label cell is shared
+  static constexpr int16_t valueWidth = 160;
+  static constexpr int16_t tableY = 52;
+  static constexpr int16_t tableHumidityX = 96;
+  static constexpr int16_t staticFrameHeight = height;
+  static constexpr Rect legend = { 168, 52, width - 168, 8 };
+  static constexpr Rect graph = { 168, 62, width - 168, height - 62 };
+};
+
+template <uint8_t Orientation>
+struct LayoutOf : LayoutFor<Orientation> {
+  using Base = LayoutFor<Orientation>;
+
+  static constexpr uint8_t font = 2;              // labels and values
+  static constexpr int16_t lineHeight = 16;       // height of a font 2 line
+  static constexpr uint8_t smallFont = 1;         // legend and overlay
+  static constexpr int16_t titleLines = 3;
+  static constexpr uint8_t valueLines = 4;        // status, temperature, humidity, dew point / heat index
+  static constexpr int16_t tableTemperatureX = 24;
+
+  static constexpr int16_t titleY(uint8_t line) { return line * lineHeight; }
+  static constexpr int16_t labelY(uint8_t index) { return Base::firstLabelY + index * Base::labelPitch; }
+  static constexpr Rect field(uint8_t index) {
+    return { 0, static_cast<int16_t>(labelY(index) + Base::labelToField), Base::valueWidth, lineHeight };
+  }
+  static constexpr int16_t tableRowY(uint8_t row) { return Base::tableY + (row + 1) * lineHeight; }
+  static constexpr Rect tableCell(uint8_t row, uint8_t column) {
+    return column == 0 ? Rect{ tableTemperatureX, tableRowY(row), Base::tableHumidityX - tableTemperatureX, lineHeight }
+                       : Rect{ Base::tableHumidityX, tableRowY(row), Base::valueWidth - Base::tableHumidityX, lineHeight };
+  }
+  static constexpr int16_t maxTableRows = (Base::staticFrameHeight - tableRowY(0)) / lineHeight;
+
+  // Profiler overlay: the legend and graph area
+  static constexpr Rect overlay = { Base::legend.x, Base::legend.y, Base::legend.w, Base::graph.bottom() - Base::legend.y };
+
+  // Pages (Pages.h): a title line on top, text pages continue in a second column when wider than tall
+  static constexpr int16_t pageTitleHeight = 20;
+  static constexpr bool pageColumns = Base::width > Base::height;
+
+  // Trend page: legend and axis ranges below the title, the plot below them
+  static constexpr int16_t trendLegendY = pageTitleHeight;
+  static constexpr int16_t trendRangeY = trendLegendY + 10;
+  static constexpr Rect trendPlot = { 0, trendRangeY + 10, Base::width, Base::height - (trendRangeY + 10) };
+
+  // Min/max page: one section per span (title line, then min/max/mean per channel), values right of
+  //  their labels
+  static constexpr uint8_t statsLines = 7;
+  static constexpr int16_t statsValueX = 64;
+  static constexpr Rect statsSection(uint8_t index) {
+    return pageColumns ? Rect{ static_cast<int16_t>(index * (Base::width / 2)), pageTitleHeight, Base::width / 2,
+                               statsLines * lineHeight }
+                       : Rect{ 0, static_cast<int16_t>(pageTitleHeight + index * (statsLines * lineHeight + 4)),
+                               Base::width, statsLines * lineHeight };
+  }
+
+  static_assert(titleY(titleLines) <= Base::firstLabelY && titleY(titleLines) <= Base::tableY,
+                "values overlap the title");
+  static_assert(field(valueLines - 1).bottom() <= Base::staticFrameHeight, "last value field runs into the graph");
+  static_assert(Base::graph.right() <= Base::width && Base::graph.bottom() <= Base::height,
+                "graph does not fit the panel");
+  static_assert(statsSection(1).right() <= Base::width && statsSection(1).bottom() <= Base::height,
+                "min/max page does not fit the panel");
+};
+
+typedef LayoutOf<DISPLAY_ORIENTATION> Layout;
@@ -0,0 +1,74 @@
+/*********************************************************************************************************
+ * ESP-NOW Sensor Mesh
+ *
+ * Description:
+ *   Fleet mode for buildings with many boards (MESH_ROLE):
+ *   - Leaf:       broadcasts every reading as a 10-byte MeshFrame over ESP-NOW. The radio is started
+ *                  for the send only and never associates with an access point, so a reading costs a
+ *                  few milliseconds of radio time instead of a Wi-Fi association.
+ *   - Aggregator: listens on MESH_CHANNEL, drops repeated frames by their sequence number and keeps
+ *                  the latest reading of every (node, sensor) pair in a fixed table. It renders the
+ *                  fleet summary (FleetView.h) and is the only unit with a Wi-Fi uplink, so the
+ *                  metrics server of the aggregator exposes the whole fleet.
+ *
+ * Frame (little endian, packed):
+ *   magic (1) | version (1) | sequence (2) | sensor (1) | status (1) | °C x 10 (2) | % x 10 (2)
+ *   The sending node is identified by the MAC address ESP-NOW reports with the frame.
+ *
+ * Notes:
+ *   - Broadcasts are not acknowledged, a leaf sends each frame MESH_REPEATS times and the aggregator
+ *      counts the extra copies as duplicates.
+ *   - ESP-NOW shares the radio channel of the station interface: when the aggregator is associated
+ *      with an access point, MESH_CHANNEL has to be the channel of that access point.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SensorSample.h"
+
+const uint8_t meshMagic = 0xD7;  // first byte of every frame
+const uint8_t meshVersion = 1;   // frame layout version
+
+// Reading of one sensor as sent over the air
+struct __attribute__((packed)) MeshFrame {
+  uint8_t magic;
+  uint8_t version;
+  uint16_t sequence;   // per leaf, wraps; repeats of a frame share it
+  uint8_t sensor;      // index in the leaf's sensor array
+  uint8_t status;      // SampleStatus
+  int16_t t_decidegC;  // temperature in °C x 10
+  uint16_t rh_decipct; // relative humidity in % x 10
+};
+static_assert(sizeof(MeshFrame) == 10, "MeshFrame is a wire format");
+
+// Aggregator view of one (node, sensor) pair
+struct MeshNode {
+  uint8_t mac[6];      // sending node
+  uint16_t sequence;   // sequence number of the latest frame
+  SensorSample sample; // latest reading, ts is millis() at its arrival
+  uint32_t frames;     // frames accepted
+  uint32_t duplicates; // repeated frames dropped
+};
+
+// Counters of the mesh link
+struct MeshStats {
+  uint32_t framesSent;     // leaf: frames broadcast (every repeat counts)
+  uint32_t framesReceived; // aggregator: frames accepted into the node table
+  uint32_t duplicates;     // aggregator: repeated frames dropped
+  uint32_t dropped;        // frames lost to a full queue or node table
+};
+
+void meshBegin();                               // bring up ESP-NOW for the role, the calling task is
+                                                //  the one woken on a received frame (aggregator)
+void meshSend(const SensorSample &sample);      // leaf: queue a reading for the send task
+bool meshSendNow(const SensorSample &sample);   // leaf: send a reading from the caller (blocking, for
+                                                //  the deep-sleep mode)
+bool meshPoll();                                // aggregator: fold received frames into the node table,
+                                                //  true if a reading changed
+bool meshNode(uint8_t slot, MeshNode &out);     // aggregator: copy of a table slot, false if unused
+bool meshNodeOnline(const MeshNode &node, uint32_t now); // heard from within MESH_NODE_TIMEOUT_MS
+uint32_t meshChangeCount();                     // aggregator: bumped on every accepted frame
+MeshStats meshStats();
+uint32_t meshRadioOnTimeMs();                   // leaf: total time the radio has been on since boot
@@ -0,0 +1,31 @@
+/*********************************************************************************************************
+ * Metrics Server
+ *
+ * Description:
+ *   Optional local HTTP server (METRICS_SERVER) for scrapers on the same network:
+ *   - GET /metrics                          Prometheus text format: the latest reading of every sensor
+ *                                            with its derived metrics, and the history aggregates of the
+ *                                            primary sensor.
+ *   - GET /api/samples?since=<n>&limit=<m>  JSON page of the raw history, oldest first.
+ *   Responses are streamed out of one preallocated buffer (one TCP segment), formatted straight from
+ *    the history store in short locked batches. Nothing is built up per request, there is no String
+ *    and no heap use on the request path.
+ *   The server runs in its own low-priority task on core 0 and holds a Wi-Fi link reference, so the
+ *    radio stays associated while it is enabled.
+ *
+ * Payload (/api/samples):
+ *   {"device":"<DEVICE_NAME>","first":<n>,"next":<n>,"samples":[[<seconds>,<°C x 10>,<% x 10>],...]}
+ *   first is the oldest sequence number still held, next is the since value for the following page.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+#include "DerivedMetrics.h"
+#include "SensorSample.h"
+
+void metricsServerBegin();                         // start the server task
+void metricsPublish(const SensorSample &sample,    // latest reading of sample.sensor and its derived
+                    const DerivedSample &derived); //  metrics, for /metrics
+uint32_t metricsRequestCount();                    // requests served since boot
@@ -0,0 +1,33 @@
+/*********************************************************************************************************
+ * OTA Update
+ *
+ * Description:
+ *   Optional over-the-air firmware updates (OTA_UPDATE). A low-priority task on core 0 fetches
+ *    http://OTA_HOST:OTA_PORT/OTA_PATH every OTA_CHECK_MS and streams the image into the inactive app
+ *    slot of partitions.csv, one flash sector at a time, while sampling and the display carry on at
+ *    their usual cadence. Once the image is complete and verified it becomes the boot partition, and
+ *    loop() restarts into it at the next quiet point, right after a reading was drawn and before the
+ *    WAIT state: the update costs one reboot, nothing else.
+ *   The server is a plain file server: an image whose app description matches the running firmware
+ *    (same ELF SHA-256) is dropped after its first chunk, so an unchanged file is never written.
+ *
+ * Notes:
+ *   - Each erase and write stalls the caches of both cores for a few milliseconds. Writing one sector
+ *      per step with OTA_CHUNK_PAUSE_MS in between keeps every stall short and lets the higher-priority
+ *      sensor and display tasks run between them; the sectors are erased as they are reached, never
+ *      the whole slot up front.
+ *   - With the bootloader's rollback enabled, a new image that boots but never gets its first reading
+ *      on screen is rolled back on the next reset (otaConfirmImage()).
+ *   - The RAM history and a telemetry batch not yet sent are lost with the restart, like on any reset.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+void otaBegin();          // start the download task
+bool otaRestartDue();     // a verified image is set to boot, restart at the next quiet point
+void otaRestart();        // restart into it, does not return
+void otaConfirmImage();   // the running image works, cancel a pending rollback
+uint32_t otaBytesWritten(); // bytes of the image being (or last) written, for the diagnostics
@@ -0,0 +1,56 @@
+/*********************************************************************************************************
+ * Pages
+ *
+ * Description:
+ *   The screen as a set of full-screen pages, stepped through with button 1 (GPIO0):
+ *   - Live:        the values and the trend graph below them, the screen drawn at boot
+ *   - Trend:       PAGE_TREND_SPAN_MINUTES of the primary sensor across the whole screen
+ *   - Min/Max:     min/max/mean of both channels over recent history and over all of it
+ *   - Diagnostics: heap, stacks and energy (DIAGNOSTICS, see Diagnostics.h)
+ *   A page is a static background (title, labels, legends) plus the values drawn over it. Each
+ *    background is rendered once, the first time its page is shown, into a full-screen sprite in
+ *    PSRAM; from then on showing the page is a single push, followed by its values.
+ *
+ * Notes:
+ *   - Only the page on screen draws. The others keep nothing up to date: the trend and min/max pages
+ *      are rebuilt from the sample history when they are shown, the live page's fields only hold
+ *      their pending text, so a hidden page costs no bus traffic and no rendering.
+ *   - Without PSRAM the backgrounds are drawn directly on every switch instead.
+ *   - Button 2 (GPIO14) keeps toggling the profiler overlay, which covers the live page's graph.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "Config.h"
+
+// Pages in button order (new pages go before COUNT)
+enum class Page : uint8_t {
+  LIVE,
+  TREND,
+  STATS,
+#if DIAGNOSTICS
+  DIAG,
+#endif
+  COUNT
+};
+
+// Value text on a text page: drawn over the background padded to its width, only when it changed
+class PageValue {
+public:
+  void draw(int16_t x, int16_t y, int16_t width, const char *text); // in the current font and colour
+  void invalidate() { _drawn = false; }                            // the background was drawn over it
+
+private:
+  char _text[24] = {};
+  bool _drawn = false;
+};
+
+void nextPage();                                        // switch to the next page on the next update
+Page currentPage();
+void drawPageBackground();                              // put the current page's background on the panel,
+                                                        //  its values are drawn again on the next update
+bool pageDirty();                                       // true if the current page has something to draw
+void updatePage();                                      // draw what changed on the current page
+void drawPageTitle(TFT_eSPI &canvas, const char *title); // title line of a page background
@@ -0,0 +1,50 @@
+/*********************************************************************************************************
+ * Loop Profiler
+ *
+ * Description:
+ *   Lightweight timing of the loop() state machine. Each state branch is timed with
+ *    esp_timer_get_time() and recorded into a fixed log-linear histogram (4 buckets per power of two,
+ *    so every bucket is within 25% of its value), from which min/max/mean/p99 are read without
+ *    keeping raw samples. The loop rate is counted over PROFILER_RATE_WINDOW_MS windows and kept in
+ *    hundredths, since loop() blocks in WAIT for most of a sample interval and runs well below 1 Hz.
+ *
+ * Output:
+ *   - Serial: a report every PROFILER_REPORT_MS (0 = off).
+ *   - Screen: an overlay in place of the trend graph, toggled with button 2 (GPIO14).
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Timed sections, one per state of the loop() state machine
+enum class ProfileSection : uint8_t {
+  READ_SENSOR,
+  UPDATE_DISPLAY,
+  WAIT,
+  ALERT,
+  COUNT
+};
+
+// Statistics of one section
+struct ProfileStats {
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t meanUs;
+  uint32_t p99Us;
+};
+
+void profilerRecord(ProfileSection section, uint32_t us); // add one timed run of a section
+void profilerLoopTick();                                 // count one loop() iteration
+ProfileStats profilerStats(ProfileSection section);       // current statistics of a section
+uint32_t profilerLoopRate_centiHz();                      // iterations per second x 100 over the last window
+void profilerReport(Print &out);                          // one line per section
+bool profilerReportDue();                                 // true once every PROFILER_REPORT_MS
+
+void profilerToggleOverlay();                             // show/hide the overlay (hiding redraws the graph)
+void invalidateProfilerOverlay();                         // the area was drawn over, redraw a shown overlay now
+bool profilerOverlayVisible();                            // true while the overlay replaces the trend graph
+bool profilerOverlayDirty();                              // true if the shown overlay is due for a refresh
+void drawProfilerOverlay();                               // draw the overlay over the trend graph area
@@ -0,0 +1,120 @@
+/*********************************************************************************************************
+ * Sample Filter
+ *
+ * Description:
+ *   Noise filter between acquisition and the redraw decision. Each channel first goes through a
+ *    median-of-N window, which removes single-sample spikes, and then through a deadband with
+ *    hysteresis: the reported value only moves once the filtered value has drifted more than one
+ *    band away from it. With each band at least one sensor LSB, a ±1 LSB flicker therefore never
+ *    reaches the display, while a real trend still shows up once it has gone past one band.
+ *
+ * Notes:
+ *   - N should be odd; the median delays a step change by (N - 1) / 2 samples.
+ *   - Failed samples pass through unchanged and reset the filter, so the first good sample after a
+ *      disconnect is reported immediately.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "Config.h"
+#include "SensorSample.h"
+
+// Median of the last N values
+template <uint8_t N>
+class MedianFilter {
+  static_assert(N > 0, "window must not be empty");
+
+public:
+  int16_t push(int16_t value) {
+    _window[_next] = value;
+    _next = (_next + 1) % N;
+    if (_count < N) {
+      _count++;
+    }
+
+    // Insertion sort of a copy, N is small
+    int16_t sorted[N];
+    memcpy(sorted, _window, sizeof(int16_t) * _count);
+    for (uint8_t i = 1; i < _count; i++) {
+      int16_t v = sorted[i];
+      int8_t j = i - 1;
+      while (j >= 0 && sorted[j] > v) {
+        sorted[j + 1] = sorted[j];
+        j--;
+      }
+      sorted[j + 1] = v;
+    }
+    return sorted[_count / 2];
+  }
+
+  void reset() { _count = 0; _next = 0; }
+
+private:
+  int16_t _window[N];
+  uint8_t _next = 0;
+  uint8_t _count = 0;
+};
+
+// Reported value that only moves once the input is more than one band away
+class Deadband {
+public:
+  explicit Deadband(int16_t band) : _band(band) {}
+
+  // Returns true if the reported value changed
+  bool update(int16_t value) {
+    int32_t difference = static_cast<int32_t>(value) - _reported;
+    if (_primed && difference <= _band && difference >= -_band) {
+      return false;
+    }
+    _reported = value;
+    _primed = true;
+    return true;
+  }
+
+  int16_t reported() const { return _reported; }
+  void reset() { _primed = false; }
+
+private:
+  int16_t _band;
+  int16_t _reported = 0;
+  bool _primed = false;
+};
+
+// Median plus deadband on both channels of a SensorSample
+template <uint8_t N>
+class SampleFilter {
+public:
+  SampleFilter(int16_t temperatureBand = DEADBAND_TEMPERATURE, int16_t humidityBand = DEADBAND_HUMIDITY)
+    : _temperatureBand(temperatureBand), _humidityBand(humidityBand) {}
+
+  // Filter a sample in place, returns true if anything the display shows changed
+  bool apply(SensorSample &sample) {
+    if (!sample.valid()) {
+      bool changed = _lastValid;
+      _lastValid = false;
+      _temperatureMedian.reset();
+      _humidityMedian.reset();
+      _temperatureBand.reset();
+      _humidityBand.reset();
+      return changed;
+    }
+
+    bool changed = !_lastValid;
+    _lastValid = true;
+    changed |= _temperatureBand.update(_temperatureMedian.push(sample.t_decidegC));
+    changed |= _humidityBand.update(_humidityMedian.push(static_cast<int16_t>(sample.rh_decipct)));
+
+    sample.t_decidegC = _temperatureBand.reported();
+    sample.rh_decipct = static_cast<uint16_t>(_humidityBand.reported());
+    return changed;
+  }
+
+private:
+  MedianFilter<N> _temperatureMedian;
+  MedianFilter<N> _humidityMedian;
+  Deadband _temperatureBand;
+  Deadband _humidityBand;
+  bool _lastValid = false;
+};
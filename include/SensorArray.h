@@ -0,0 +1,38 @@
+/*********************************************************************************************************
+ * Sensor Array
+ *
+ * Description:
+ *   The DHT sensors of the board, built at compile time from SENSOR_PINS and SENSOR_TYPES in Config.h.
+ *    Sensor i reports its samples with SensorSample::sensor = i; sensor 0 is the primary sensor.
+ *   The RMT backend shares one receive channel between all sensors, so only one of them may be
+ *    reading at a time. The sensor task staggers the reads for that (see SensorTask.h).
+**********************************************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <utility>
+#include "Config.h"
+#include "DhtSensor.h"
+
+constexpr uint8_t sensorPins[] = SENSOR_PINS;
+constexpr DhtType sensorTypes[] = SENSOR_TYPES;
+constexpr uint8_t sensorCount = sizeof(sensorPins) / sizeof(sensorPins[0]);
+constexpr uint8_t maxSensors = 8;
+
+static_assert(sensorCount > 0 && sensorCount <= maxSensors, "SENSOR_PINS must list 1 to 8 pins");
+static_assert(sizeof(sensorTypes) / sizeof(sensorTypes[0]) == sensorCount,
+              "SENSOR_TYPES must have one entry per pin in SENSOR_PINS");
+
+// Longest minimum read interval in the array, the round-robin interval may not be shorter
+constexpr uint32_t slowestSensorIntervalMs(uint8_t i = 0) {
+  return i == sensorCount ? 0
+         : dhtProfile(sensorTypes[i]).minIntervalMs > slowestSensorIntervalMs(i + 1)
+           ? dhtProfile(sensorTypes[i]).minIntervalMs : slowestSensorIntervalMs(i + 1);
+}
+static_assert(SENSOR_READ_INTERVAL_MS >= slowestSensorIntervalMs(),
+              "SENSOR_READ_INTERVAL_MS is shorter than a sensor's minimum sampling period");
+
+typedef std::array<DhtSensor, sensorCount> SensorArray;
+
+extern SensorArray sensors;
@@ -0,0 +1,30 @@
+/*********************************************************************************************************
+ * Sensor Sample
+ *
+ * Description:
+ *   One reading of the sensor, with temperature and humidity taken from the same 40-bit frame.
+ *    Values are fixed-point integers in tenths (the 0.1 resolution of the DHT sensors), so samples
+ *    stay integer from the driver to the display without a float conversion in between.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+// Outcome of the bus transaction behind a sample
+enum class SampleStatus : uint8_t {
+  OK,             // frame received and checksum valid
+  TIMEOUT,        // sensor did not answer in time
+  CHECKSUM_ERROR, // frame received but corrupted
+  NOT_CONNECTED   // line check failed, no start pulse was sent
+};
+
+struct SensorSample {
+  int16_t t_decidegC;  // temperature in °C x 10
+  uint16_t rh_decipct; // relative humidity in % x 10
+  uint32_t ts;         // millis() at the end of the transaction
+  SampleStatus status; // values are only meaningful when status is OK
+  uint8_t sensor;      // index of the sensor in the sensor array
+
+  bool valid() const { return status == SampleStatus::OK; }
+};
@@ -0,0 +1,35 @@
+/*********************************************************************************************************
+ * Sensor Acquisition Task
+ *
+ * Description:
+ *   Runs the reads of the sensor array in their own FreeRTOS task pinned to core 0, round-robin at a
+ *    fixed cadence set by vTaskDelayUntil(). Every read (valid or not) is published as a SensorSample
+ *    through a lock-free SPSC queue, so a slow display or network path on core 1 never shifts the
+ *    sampling instants.
+ *   While a sensor is not answering, the retry interval doubles after every failed read, up to
+ *    SENSOR_BACKOFF_MAX_MS, and snaps back to the normal interval on the first good read.
+ *   The consumer is woken by a task notification when a sample lands, so it can block instead of
+ *    polling the queue.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "DhtSensor.h"
+#include "SensorArray.h"
+#include "SensorSample.h"
+
+// Start a read and wait for its result, yielding while the frame is captured
+SensorSample readSensor(DhtSensor &sensor);
+
+// Start every sensor of the array and the pinned acquisition task, the calling task becomes the consumer
+void startSensorTask();
+
+// Consumer side: take the next sample, never blocks
+bool receiveSensorSample(SensorSample &sample);
+
+// Consumer side: take the next sample, blocking until one lands or the timeout expires
+bool waitForSensorSample(SensorSample &sample, TickType_t timeout);
+
+// Samples lost because the consumer fell behind
+uint32_t droppedSensorSamples();
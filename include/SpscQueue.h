@@ -0,0 +1,55 @@
+/*********************************************************************************************************
+ * Single-Producer / Single-Consumer Queue
+ *
+ * Description:
+ *   Fixed-capacity lock-free ring buffer for handing data from one task to another (e.g. from the
+ *    sensor task on core 0 to the display loop on core 1). push() may only be called by the producer
+ *    and pop() only by the consumer; neither ever blocks or disables interrupts.
+ *
+ * Notes:
+ *   - Capacity must be a power of two so the indices can wrap with a mask.
+ *   - The producer publishes an item with a release store of the head index, the consumer frees a
+ *      slot with a release store of the tail index.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer side: returns false (and drops the item) if the queue is full
+  bool push(const T &item) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    _items[head & (Capacity - 1)] = item;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: returns false if the queue is empty
+  bool pop(T &item) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (_head.load(std::memory_order_acquire) == tail) {
+      return false;
+    }
+    item = _items[tail & (Capacity - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+  }
+
+private:
+  T _items[Capacity];
+  std::atomic<size_t> _head{0}; // written by the producer only
+  std::atomic<size_t> _tail{0}; // written by the consumer only
+};
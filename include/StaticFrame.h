@@ -0,0 +1,20 @@
+/*********************************************************************************************************
+ * Static Frame Cache
+ *
+ * Description:
+ *   Keeps a 1-bit image of the static screen text (title and labels) in flash, in the NVS partition, so
+ *    a boot blits it in a few block writes instead of sending the labels glyph by glyph over the bus.
+ *   The image is rendered once into a 1-bit sprite in RAM, packed and stored under a key computed from
+ *    the label layout; a layout change gives a new key and the cache is rebuilt on the next boot.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+#include "Config.h"
+
+// Draw the cached frame over rows 0..height-1, false if there is no image for this key
+bool blitStaticFrame(uint32_t key, int16_t width, int16_t height);
+
+// Pack a rendered 1-bit frame sprite and store it under key
+void storeStaticFrame(uint32_t key, TFT_eSprite &frame);
@@ -0,0 +1,31 @@
+/*********************************************************************************************************
+ * Telemetry Uplink
+ *
+ * Description:
+ *   Batched HTTP uplink of samples to a backend. Samples are coalesced into a batch and the radio is
+ *    only brought up when the batch has to go out:
+ *   - the batch is full (TELEMETRY_BATCH samples),
+ *   - a reading moved by more than its threshold since the last uploaded value, or
+ *   - the oldest sample in the batch has waited TELEMETRY_MAX_LATENCY_MS.
+ *   The upload runs in its own low-priority task, so loop() only copies the sample into the batch.
+ *   The payload is written into a preallocated buffer, and the TCP connection is kept alive for
+ *    TELEMETRY_LINGER_MS so back-to-back batches share one connection and one radio wake.
+ *
+ * Payload (JSON):
+ *   {"device":"<DEVICE_NAME>","samples":[[<seconds>,<°C x 10>,<% x 10>,<dew point °C x 10>,
+ *    <heat index °C x 10>,<g/m³ x 10>],...]}
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+#include "DerivedMetrics.h"
+#include "SensorSample.h"
+
+void telemetryBegin();                                       // start the uplink task
+void telemetryAdd(uint32_t seconds, const SensorSample &sample, // add a sample with its derived metrics,
+                  const DerivedSample &derived);                //  flush on a trigger
+bool telemetrySendNow();                                     // send the open batch from the caller
+                                                             //  (blocking, for the deep-sleep mode)
+uint32_t telemetryDroppedSamples();                          // samples lost to a busy or failed uplink
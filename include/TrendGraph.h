@@ -0,0 +1,68 @@
+/*********************************************************************************************************
+ * Trend Graph
+ *
+ * Description:
+ *   Scrolling graph of the last GRAPH_SPAN_MINUTES of samples, below the humidity field. The graph
+ *    lives in a sprite with one column per time slot: when a new slot starts the sprite is scrolled
+ *    left by one column, and each sample only redraws the newest column (one vertical segment per
+ *    channel, joining the previous column's value to the current one). The existing columns are
+ *    never rendered again.
+ *   The plot itself is a TrendPlot, so the trend page (Pages.h) can keep a larger one over a longer
+ *    span, rebuilt from the history when the page is shown.
+ *
+ * Notes:
+ *   - The value axes are fixed (GRAPH_T_MIN..GRAPH_T_MAX, GRAPH_RH_MIN..GRAPH_RH_MAX) so a new sample
+ *      never forces the old columns to be rescaled.
+ *   - A column shows the mean of the samples that fell into its time slot.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "SensorSample.h"
+
+class History;
+
+// Scrolling two-channel plot in a sprite, one column per time slot
+class TrendPlot {
+public:
+  explicit TrendPlot(TFT_eSPI *panel) : _sprite(panel) {}
+
+  bool begin(int16_t width, int16_t height, uint32_t spanMinutes, bool psram); // create the sprite
+  void clear();                                           // blank plot, the next sample starts a column
+  bool add(int16_t t_decidegC, uint16_t rh_decipct, uint32_t tsMs); // add a sample to the newest column,
+                                                          //  true if the older columns moved too
+  void replay(const History &history);                    // rebuild the span from the stored samples
+  TFT_eSprite &sprite() { return _sprite; }
+
+private:
+  int16_t valueToRow(int32_t value, int32_t minimum, int32_t maximum) const;
+  void drawSegment(int16_t x, int16_t previousRow, int16_t row, uint16_t colour);
+  void drawColumn(int16_t x);                             // clear and redraw the column of the current slot
+  void startSlot(uint32_t slot, uint32_t elapsed);        // the running sums move on to a new slot
+
+  TFT_eSprite _sprite;
+  int16_t _width = 0;
+  int16_t _height = 0;
+  uint32_t _slotMs = 0;                  // time covered by one column
+
+  bool _haveSlot = false;
+  uint32_t _currentSlot = 0;             // time slot of the newest column
+  int32_t _temperatureSum = 0;           // running sums of the newest column
+  uint32_t _humiditySum = 0;
+  uint16_t _slotCount = 0;
+  int16_t _previousTemperatureY = -1;    // row of the previous column, -1 if it was blank
+  int16_t _previousHumidityY = -1;
+  int16_t _newestTemperatureY = -1;      // row of the newest column
+  int16_t _newestHumidityY = -1;
+};
+
+void drawTrendLegend(TFT_eSPI &canvas, int16_t x, int16_t y, uint16_t spanMinutes); // "TEMP RH  last N min"
+
+void initTrendGraph();                          // create the graph sprite
+void drawTrendGraphFrame();                     // draw the legend above the graph (static elements)
+void invalidateTrendGraph();                    // the graph area was cleared, push the graph again
+void addTrendSample(const SensorSample &sample); // draw the sample into the newest column
+bool trendGraphDirty();                         // true if the sprite changed since the last push
+void updateTrendGraph();                        // push the graph sprite, or only its newest column
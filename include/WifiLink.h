@@ -0,0 +1,20 @@
+/*********************************************************************************************************
+ * Wi-Fi Link
+ *
+ * Description:
+ *   Shared, reference-counted station connection. Every user (telemetry uplink, web server, ...)
+ *    acquires the link while it needs the network and releases it afterwards; the radio is only
+ *    associated while at least one user holds it, and is switched off as soon as the last one lets go.
+ *    The time the radio spends on is accumulated for the diagnostics.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+void wifiBegin();                     // create the link lock, from setup() before any user task starts
+bool wifiAcquire(uint32_t timeoutMs); // connect if needed, blocks until connected or timeout (false)
+void wifiRelease();                   // drop one reference, the radio goes off with the last one
+bool wifiConnected();                 // true while associated
+uint32_t wifiOnTimeMs();              // total time the radio has been on since boot
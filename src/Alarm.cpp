@@ -0,0 +1,294 @@
+/*********************************************************************************************************
+ * Threshold Alarms
+ *
+ * How It Works:
+ *   1. evaluateAlarms() runs in the sensor task after every read. It works on the task's own state of
+ *       each sensor only (no lock), compares the reading with the limits and the rate reference and
+ *       builds the new alarm mask.
+ *   2. On a change the mask is stored for the other tasks, the output pin is set from the masks of all
+ *       sensors and the pin latency is taken, before anything else happens.
+ *   3. The change is queued as an AlarmEvent (SPSC queue) and the loop task is notified; the sample
+ *       itself is published after this, so loop() always sees the event first.
+ *   4. handleAlarmEvents() runs in the ALERT state of loop(): it drains the queue, draws the alert for
+ *       the newest raised alarm and takes the screen latency, or gives the screen back once nothing
+ *       is active any more.
+**********************************************************************************************************/
+
+#include "Alarm.h"
+
+#if ALARMS
+
+#include <atomic>
+#include <esp_timer.h>
+#include "Display.h"
+#include "DisplayPower.h"
+#include "DisplayPush.h"
+#include "FixedFormat.h"
+#include "Layout.h"
+#include "Pages.h"
+#include "SensorArray.h"
+#include "SpscQueue.h"
+
+namespace {
+// Alarm state of one sensor, sensor task only
+struct SensorAlarms {
+  uint8_t active;        // current alarm mask
+  bool haveReference;    // reference* hold the reading rates are measured against
+  int16_t referenceTemperature;
+  uint16_t referenceHumidity;
+  uint32_t referenceTs;
+};
+
+SensorAlarms states[sensorCount];
+std::atomic<uint8_t> activeMasks[sensorCount];        // copy of states[].active for the other tasks
+SpscQueue<AlarmEvent, ALARM_QUEUE> eventQueue;        // sensor task -> loop()
+TaskHandle_t wakeTask = nullptr;                      // notified on every event
+std::atomic<uint32_t> raisedCount{0};
+std::atomic<uint32_t> maxPinLatency{0};
+std::atomic<uint32_t> droppedEvents{0};
+
+// loop() side
+AlarmEvent shown;                                     // event behind the alert on screen
+bool screenVisible = false;
+uint32_t maxScreenLatency = 0;
+uint32_t overBudget = 0;
+
+constexpr uint8_t bit(AlarmKind kind) {
+  return 1 << static_cast<uint8_t>(kind);
+}
+
+// Level alarm with hysteresis: raised beyond the limit, cleared once back inside it by the hysteresis
+bool beyond(bool active, int32_t value, int32_t limit, int32_t hysteresis, bool high) {
+  if (high) {
+    return active ? value > limit - hysteresis : value > limit;
+  }
+  return active ? value < limit + hysteresis : value < limit;
+}
+
+// Change per minute of a value that moved by delta within elapsedMs
+uint32_t ratePerMinute(int32_t delta, uint32_t elapsedMs) {
+  uint32_t magnitude = delta < 0 ? -delta : delta;
+  return elapsedMs == 0 ? UINT32_MAX : (uint64_t)magnitude * 60000 / elapsedMs;
+}
+
+// New alarm mask of a sensor for a valid reading
+uint8_t evaluate(SensorAlarms &state, const SensorSample &sample) {
+  uint8_t active = state.active;
+  uint8_t next = 0;
+  int32_t temperature = sample.t_decidegC;
+  int32_t humidity = sample.rh_decipct;
+
+  if (beyond(active & bit(AlarmKind::T_HIGH), temperature, ALARM_T_HIGH, ALARM_HYSTERESIS_T, true)) {
+    next |= bit(AlarmKind::T_HIGH);
+  }
+  if (beyond(active & bit(AlarmKind::T_LOW), temperature, ALARM_T_LOW, ALARM_HYSTERESIS_T, false)) {
+    next |= bit(AlarmKind::T_LOW);
+  }
+  if (beyond(active & bit(AlarmKind::RH_HIGH), humidity, ALARM_RH_HIGH, ALARM_HYSTERESIS_RH, true)) {
+    next |= bit(AlarmKind::RH_HIGH);
+  }
+  if (beyond(active & bit(AlarmKind::RH_LOW), humidity, ALARM_RH_LOW, ALARM_HYSTERESIS_RH, false)) {
+    next |= bit(AlarmKind::RH_LOW);
+  }
+
+  // Rates against a reference at least one window old, the rate alarms hold until the next window
+  next |= active & (bit(AlarmKind::T_RATE) | bit(AlarmKind::RH_RATE));
+  uint32_t elapsed = sample.ts - state.referenceTs;
+  if (!state.haveReference) {
+    state.haveReference = true;
+  } else if (elapsed >= ALARM_RATE_WINDOW_MS) {
+    next &= ~(bit(AlarmKind::T_RATE) | bit(AlarmKind::RH_RATE));
+    if (ALARM_RATE_T > 0 && ratePerMinute(temperature - state.referenceTemperature, elapsed) > ALARM_RATE_T) {
+      next |= bit(AlarmKind::T_RATE);
+    }
+    if (ALARM_RATE_RH > 0 && ratePerMinute(humidity - state.referenceHumidity, elapsed) > ALARM_RATE_RH) {
+      next |= bit(AlarmKind::RH_RATE);
+    }
+  } else {
+    return next; // keep the reference until the window is full
+  }
+  state.referenceTemperature = sample.t_decidegC;
+  state.referenceHumidity = sample.rh_decipct;
+  state.referenceTs = sample.ts;
+  return next;
+}
+
+// Drive the output pin from the masks of all sensors
+void updateOutput() {
+#if ALARM_PIN >= 0
+  bool any = false;
+  for (const std::atomic<uint8_t> &mask : activeMasks) {
+    any |= mask.load(std::memory_order_relaxed) != 0;
+  }
+  digitalWrite(ALARM_PIN, any == (ALARM_ACTIVE_HIGH != 0) ? HIGH : LOW);
+#endif
+}
+
+// True if any sensor has an active alarm
+bool anyActive() {
+  for (const std::atomic<uint8_t> &mask : activeMasks) {
+    if (mask.load(std::memory_order_relaxed) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *kindLabels[static_cast<uint8_t>(AlarmKind::COUNT)] = {
+  "Temperature high", "Temperature low", "Humidity high", "Humidity low",
+  "Temperature rate", "Humidity rate"
+};
+
+// Draw the alert for an event over the whole screen
+void drawAlert(const AlarmEvent &event) {
+  displayFence(); // direct drawing, let the queued pushes finish first
+  tft.fillScreen(TFT_RED);
+  tft.setTextColor(TFT_WHITE, TFT_RED);
+  const int16_t centre = Layout::width / 2;
+  int16_t y = 8;
+  tft.drawCentreString("ALARM", centre, y, 4);
+  y += 34;
+
+  char line[24];
+  if (sensorCount > 1) {
+    snprintf(line, sizeof(line), "Sensor %u", event.sample.sensor + 1);
+    tft.drawCentreString(line, centre, y, Layout::font);
+    y += Layout::lineHeight;
+  }
+  DeciText temperatureText, humidityText;
+  formatDeci(temperatureText, event.sample.t_decidegC, 'C');
+  formatDeci(humidityText, static_cast<int16_t>(event.sample.rh_decipct), '%');
+  snprintf(line, sizeof(line), "%s  %s", temperatureText, humidityText);
+  tft.drawCentreString(line, centre, y, Layout::font);
+  y += Layout::lineHeight + 8;
+
+  for (uint8_t kind = 0; kind < static_cast<uint8_t>(AlarmKind::COUNT); kind++) {
+    if (event.active & (1 << kind)) {
+      tft.drawCentreString(kindLabels[kind], centre, y, Layout::font);
+      y += Layout::lineHeight;
+    }
+  }
+
+  tft.drawCentreString("Press to acknowledge", centre, Layout::height - 12, Layout::smallFont);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.setTextFont(Layout::font);
+}
+
+// Give the screen back to the normal view
+void removeAlert() {
+  screenVisible = false;
+  drawPageBackground(); // the page's values are drawn again on the next update
+}
+}
+
+void alarmsBegin() {
+  wakeTask = xTaskGetCurrentTaskHandle();
+#if ALARM_PIN >= 0
+  pinMode(ALARM_PIN, OUTPUT);
+  updateOutput();
+#endif
+}
+
+void evaluateAlarms(const SensorSample &sample, int64_t landedUs) {
+  if (!sample.valid()) {
+    return; // a failed read neither raises nor clears
+  }
+
+  SensorAlarms &state = states[sample.sensor];
+  uint8_t next = evaluate(state, sample);
+  if (next == state.active) {
+    return;
+  }
+  uint8_t raised = next & ~state.active;
+  state.active = next;
+
+  // The output pin first, everything else can wait
+  activeMasks[sample.sensor].store(next, std::memory_order_relaxed);
+  updateOutput();
+  uint32_t pinLatency = esp_timer_get_time() - landedUs;
+  if (pinLatency > maxPinLatency.load(std::memory_order_relaxed)) {
+    maxPinLatency.store(pinLatency, std::memory_order_relaxed);
+  }
+  if (raised != 0) {
+    raisedCount.fetch_add(__builtin_popcount(raised), std::memory_order_relaxed);
+  }
+
+  // Hand the change to loop(), ahead of the sample
+  AlarmEvent event = { sample, next, raised, landedUs };
+  if (eventQueue.push(event)) {
+    xTaskNotifyGive(wakeTask);
+  } else {
+    droppedEvents.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool alarmPending() {
+  return !eventQueue.empty();
+}
+
+void handleAlarmEvents() {
+  AlarmEvent event;
+  bool draw = false;
+  while (eventQueue.pop(event)) {
+    if (event.raised != 0) {
+      shown = event;
+      draw = true;
+    } else if (screenVisible && event.sample.sensor == shown.sample.sensor) {
+      shown = event; // fewer alarms left on the sensor behind the alert
+      draw = shown.active != 0;
+    }
+  }
+
+  if (!anyActive()) {
+    if (screenVisible) {
+      removeAlert();
+    }
+    return;
+  }
+  if (!draw) {
+    return; // acknowledged, or a change of another sensor
+  }
+
+  displayActivity(); // wake the panel before drawing
+  drawAlert(shown);
+  uint32_t latency = esp_timer_get_time() - shown.landedUs;
+  if (!screenVisible || shown.raised != 0) {
+    // Only the first draw of a raised alarm counts as its response
+    if (latency > maxScreenLatency) {
+      maxScreenLatency = latency;
+    }
+    if (latency > (uint32_t)ALARM_SCREEN_BUDGET_MS * 1000) {
+      overBudget++;
+    }
+  }
+  screenVisible = true;
+  shown.raised = 0;
+}
+
+bool alarmScreenVisible() {
+  return screenVisible;
+}
+
+void acknowledgeAlarm() {
+  if (screenVisible) {
+    removeAlert();
+  }
+}
+
+uint8_t activeAlarms(uint8_t sensor) {
+  return activeMasks[sensor].load(std::memory_order_relaxed);
+}
+
+const char *alarmKindName(AlarmKind kind) {
+  const char *names[static_cast<uint8_t>(AlarmKind::COUNT)] = {
+    "t_high", "t_low", "rh_high", "rh_low", "t_rate", "rh_rate"
+  };
+  return names[static_cast<uint8_t>(kind)];
+}
+
+AlarmStats alarmStats() {
+  return { raisedCount.load(std::memory_order_relaxed), maxPinLatency.load(std::memory_order_relaxed),
+           maxScreenLatency, overBudget, droppedEvents.load(std::memory_order_relaxed) };
+}
+
+#endif // ALARMS
@@ -0,0 +1,48 @@
+/*********************************************************************************************************
+ * Buttons
+ *
+ * How It Works:
+ *   1. A falling edge on a button pin runs its ISR, which ignores edges within BUTTON_DEBOUNCE_MS of the
+ *       previous accepted one (contact bounce).
+ *   2. An accepted press sets the button's bit and gives the loop task's notification, which ends a
+ *       blocking wait in the WAIT state.
+ *   3. takeButtonPresses() atomically takes and clears the latched bits.
+**********************************************************************************************************/
+
+#include "Buttons.h"
+
+#include <atomic>
+
+namespace {
+std::atomic<uint8_t> pressed{0};
+TaskHandle_t wakeTask = nullptr;
+volatile TickType_t lastPress[2] = {0, 0};
+
+void IRAM_ATTR latchPress(uint8_t index) {
+  TickType_t now = xTaskGetTickCountFromISR();
+  if (now - lastPress[index] < pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS)) {
+    return; // bounce
+  }
+  lastPress[index] = now;
+  pressed.fetch_or(1 << index);
+
+  BaseType_t higherPriorityWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(wakeTask, &higherPriorityWoken);
+  portYIELD_FROM_ISR(higherPriorityWoken);
+}
+
+void IRAM_ATTR onButton1() { latchPress(0); }
+void IRAM_ATTR onButton2() { latchPress(1); }
+}
+
+void buttonsBegin() {
+  wakeTask = xTaskGetCurrentTaskHandle();
+  pinMode(BUTTON_1_PIN, INPUT_PULLUP);
+  pinMode(BUTTON_2_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_1_PIN), onButton1, FALLING);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_2_PIN), onButton2, FALLING);
+}
+
+uint8_t takeButtonPresses() {
+  return pressed.exchange(0);
+}
@@ -0,0 +1,146 @@
+/*********************************************************************************************************
+ * Derived Metrics
+ *
+ * How It Works:
+ *   1. The saturation vapour pressure of the temperature is interpolated from the table (Pa x 100).
+ *   2. Scaled by the relative humidity it gives the actual vapour pressure e. The table segment that
+ *       brackets e, found by binary search, interpolated backwards gives the dew point.
+ *   3. Absolute humidity is e / (Rv * T) with Rv = 461.5 J/(kg K), in integer arithmetic.
+ *   4. The heat index polynomial runs in °F x 10 with coefficients scaled by 1e8; every term is divided
+ *       by its own power of ten before the sum, so no intermediate value leaves 64 bits.
+**********************************************************************************************************/
+
+#include "DerivedMetrics.h"
+
+namespace {
+const int16_t tableMinimum = -400; // °C x 10 of the first entry
+const int16_t tableMaximum = 800;  // °C x 10 of the last entry
+
+// Saturation vapour pressure over water in Pa x 100, one entry per °C from -40 to 80 °C
+const uint32_t saturationPressure[] = {
+  1902, 2109, 2336, 2586, 2858, 3157, 3484, 3840,  // -40..-33 °C
+  4230, 4654, 5117, 5620, 6168, 6764, 7410, 8112,  // -32..-25 °C
+  8872, 9696, 10588, 11553, 12597, 13723, 14939, 16251,  // -24..-17 °C
+  17665, 19187, 20826, 22589, 24483, 26518, 28703, 31047,  // -16..-9 °C
+  33559, 36251, 39134, 42218, 45517, 49043, 52809, 56830,  // -8..-1 °C
+  61120, 65695, 70570, 75763, 81292, 87174, 93430, 100079,  // 0..7 °C
+  107143, 114643, 122603, 131046, 139998, 149483, 159531, 170167,  // 8..15 °C
+  181423, 193327, 205913, 219212, 233260, 248090, 263742, 280251,  // 16..23 °C
+  297659, 316006, 335334, 355689, 377115, 399660, 423372, 448303,  // 24..31 °C
+  474505, 502031, 530939, 561284, 593128, 626531, 661558, 698274,  // 32..39 °C
+  736746, 777044, 819241, 863409, 909627, 957971, 1008523, 1061367,  // 40..47 °C
+  1116588, 1174274, 1234516, 1297407, 1363042, 1431521, 1502945, 1577416,  // 48..55 °C
+  1655043, 1735933, 1820201, 1907960, 1999329, 2094429, 2193384, 2296322,  // 56..63 °C
+  2403374, 2514671, 2630353, 2750558, 2875431, 3005117, 3139768, 3279536,  // 64..71 °C
+  3424580, 3575059, 3731139, 3892987, 4060774, 4234677, 4414874, 4601548,  // 72..79 °C
+  4794885,  // 80 °C
+};
+const uint8_t tableSize = sizeof(saturationPressure) / sizeof(saturationPressure[0]);
+static_assert(tableSize == (tableMaximum - tableMinimum) / 10 + 1, "one entry per °C");
+
+// Saturation vapour pressure at a temperature (°C x 10), in Pa x 100
+uint32_t saturationAt(int16_t t_decidegC) {
+  int32_t offset = t_decidegC < tableMinimum ? 0 : (t_decidegC > tableMaximum ? tableMaximum - tableMinimum : t_decidegC - tableMinimum);
+  uint8_t index = offset / 10;
+  if (index == tableSize - 1) {
+    return saturationPressure[index];
+  }
+  uint32_t low = saturationPressure[index];
+  return low + (saturationPressure[index + 1] - low) * (offset % 10) / 10;
+}
+
+// Temperature (°C x 10) at which the saturation pressure is e (Pa x 100)
+int16_t temperatureAt(uint32_t e) {
+  if (e <= saturationPressure[0]) {
+    return tableMinimum;
+  }
+  if (e >= saturationPressure[tableSize - 1]) {
+    return tableMaximum;
+  }
+
+  // Last entry not above e
+  uint8_t low = 0;
+  uint8_t high = tableSize - 1;
+  while (high - low > 1) {
+    uint8_t middle = (low + high) / 2;
+    if (saturationPressure[middle] <= e) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  uint32_t span = saturationPressure[high] - saturationPressure[low];
+  return tableMinimum + low * 10 + (10 * (e - saturationPressure[low]) + span / 2) / span;
+}
+
+// Integer square root
+uint32_t isqrt(uint64_t value) {
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return static_cast<uint32_t>(root);
+}
+
+// NWS heat index, temperature in °F x 10, relative humidity in % x 10, result in °F x 10
+int32_t heatIndexF(int32_t t, int32_t rh) {
+  // Steadman's simple formula, good enough as long as its mean with the temperature stays below 80 °F
+  int32_t simple = (10 * t + 6100 + 12 * (t - 680) + (94 * rh) / 100) / 20;
+  if ((simple + t) / 2 < 800) {
+    return simple;
+  }
+
+  // Rothfusz regression, sum of a * T^i * RH^j; in tenths each term is divided by 10^(i + j - 1)
+  const int64_t T = t;
+  const int64_t R = rh;
+  int64_t sum = -4237900000LL * 10            // -42.379
+              + 204901523LL * T               // 2.04901523 T
+              + 1014333127LL * R              // 10.14333127 RH
+              - 22475541LL * T * R / 10       // 0.22475541 T RH
+              - 683783LL * T * T / 10         // 0.00683783 T^2
+              - 5481717LL * R * R / 10        // 0.05481717 RH^2
+              + 122874LL * T * T * R / 100    // 0.00122874 T^2 RH
+              + 85282LL * T * R * R / 100     // 0.00085282 T RH^2
+              - 199LL * T * T * R * R / 1000; // 0.00000199 T^2 RH^2
+  int32_t index = static_cast<int32_t>(sum / 100000000LL);
+
+  // Adjustments at the humidity extremes
+  if (rh < 130 && t >= 800 && t <= 1120) {
+    int32_t distance = t > 950 ? t - 950 : 950 - t;
+    uint32_t root = isqrt(((uint64_t)(170 - distance) << 32) / 170); // sqrt((17 - |T - 95|) / 17), Q16
+    index -= static_cast<int32_t>(((int64_t)(130 - rh) * root) >> 18);  // (13 - RH) / 4 * root
+  } else if (rh > 850 && t >= 800 && t <= 870) {
+    index += (rh - 850) * (870 - t) / 500;                              // (RH - 85) / 10 * (87 - T) / 5
+  }
+  return index;
+}
+}
+
+DerivedSample deriveMetrics(int16_t t_decidegC, uint16_t rh_decipct) {
+  DerivedSample derived;
+  uint16_t rh = rh_decipct > 1000 ? 1000 : rh_decipct;
+
+  // Actual vapour pressure, Pa x 100
+  uint32_t e = (uint64_t)saturationAt(t_decidegC) * rh / 1000;
+  derived.dewPoint_decidegC = rh == 0 ? tableMinimum : temperatureAt(e);
+
+  // rho = e / (Rv T): g/m³ x 10 = 20000 * e / (4615 * T) with e in Pa x 100 and T in K x 20
+  uint32_t kelvinX2 = 2 * t_decidegC + 5463; // (273.15 + T) K x 20
+  derived.absHumidity_decigm3 = static_cast<uint16_t>((20000ULL * e + 4615ULL * kelvinX2 / 2) / (4615ULL * kelvinX2));
+
+  // Heat index in °F, back to °C x 10 (rounded)
+  int32_t fahrenheit = t_decidegC * 9 / 5 + 320;
+  int32_t index = (heatIndexF(fahrenheit, rh) - 320) * 5;
+  derived.heatIndex_decidegC = static_cast<int16_t>(index >= 0 ? (index + 4) / 9 : (index - 4) / 9);
+  return derived;
+}
@@ -0,0 +1,73 @@
+/*********************************************************************************************************
+ * DHT Sensor Driver - Adafruit backend
+ *
+ * Description:
+ *   Fallback backend built on the Adafruit DHT library. The read itself is blocking (start pulse plus
+ *    the bit-banged frame with interrupts disabled), so startRead() does all the work and poll()
+ *    only reports the result.
+ *   The frame is read once with read(true); both values are then taken from the library's cached
+ *    copy of that frame, so a sample never mixes two bus transactions.
+**********************************************************************************************************/
+
+#include "DhtSensor.h"
+
+#if DHT_BACKEND == DHT_BACKEND_ADAFRUIT
+
+#include <DHT.h>
+
+DhtSensor::DhtSensor(uint8_t pin, const DhtProfile &profile) : _pin(pin), _profile(profile) {}
+
+void DhtSensor::begin() {
+  DHT *dht = new DHT(_pin, static_cast<uint8_t>(_profile.type)); // DHT11 = 11, DHT22 = 22 in the library too
+  dht->begin();
+  _driver = dht;
+}
+
+bool DhtSensor::startRead() {
+  if (_driver == nullptr) {
+    return false; // begin() not called
+  }
+
+#if DHT_LINE_CHECK
+  if (!lineConnected()) {
+    // Fail fast, without the library's blocking timeout
+    _sample.ts = millis();
+    _sample.status = SampleStatus::NOT_CONNECTED;
+    _status = Status::NOT_CONNECTED;
+    return true;
+  }
+#endif
+
+  // One forced transaction, then both values from its cached frame
+  DHT *dht = static_cast<DHT *>(_driver);
+  bool received = dht->read(true);
+  float temperature = dht->readTemperature();
+  float humidity = dht->readHumidity();
+
+  _sample.ts = millis();
+  if (!received || isnan(temperature) || isnan(humidity)) {
+    _sample.status = SampleStatus::TIMEOUT; // sensor not connected or malfunctioning
+    _status = Status::TIMEOUT;
+  } else {
+    _sample.t_decidegC = static_cast<int16_t>(lroundf(temperature * 10));
+    _sample.rh_decipct = static_cast<uint16_t>(lroundf(humidity * 10));
+    _sample.status = SampleStatus::OK;
+    _status = Status::OK;
+  }
+  return true;
+}
+
+bool DhtSensor::lineConnected() {
+  // Weak pull-down against the module's pull-up resistor
+  pinMode(_pin, INPUT_PULLDOWN);
+  delayMicroseconds(10);
+  bool connected = digitalRead(_pin) == HIGH;
+  pinMode(_pin, INPUT_PULLUP);
+  return connected;
+}
+
+DhtSensor::Status DhtSensor::poll() {
+  return _status;
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*********************************************************************************************************
+ * DHT Sensor Driver - RMT backend
+ *
+ * How It Works:
+ *   1. startRead() pulls the data line low and arms a one-shot esp_timer for the start pulse length.
+ *   2. The timer callback releases the line and starts an RMT receive on the same pin.
+ *   3. The RMT peripheral records every high/low period of the sensor answer into its own memory,
+ *       with no CPU involvement, and hands the finished pulse train over through a ring buffer once
+ *       the line has been idle for longer than any valid pulse.
+ *   4. poll() picks the pulse train up, turns the high periods into bits, checks the frame and decodes
+ *       both values from it into one SensorSample.
+ *   5. All sensors share the one RX channel. The first begin() installs the driver, and a read routes
+ *       the channel input to its own pin with rmt_set_gpio() and holds the channel until it finishes.
+ *
+ * Frame Timing (per datasheet):
+ *   - Response: 80 us low, 80 us high
+ *   - Each bit: 50 us low, then 26-28 us high for a 0 or 70 us high for a 1
+**********************************************************************************************************/
+
+#include "DhtSensor.h"
+
+#if DHT_BACKEND == DHT_BACKEND_RMT
+
+#include <driver/gpio.h>
+#include <driver/rmt.h>
+#include <esp_timer.h>
+#include <freertos/ringbuf.h>
+
+namespace {
+const rmt_channel_t rxChannel = RMT_CHANNEL_4; // first RX-capable channel on the ESP32-S3
+const int64_t frameTimeoutUs = 6000;           // a complete answer takes at most ~5 ms
+const uint16_t idleThresholdUs = 200;          // line idle for longer than this ends the capture
+const uint16_t oneThresholdUs = 48;            // high periods longer than this are 1 bits
+
+RingbufHandle_t sharedRingbuf = nullptr;       // ring buffer of the shared channel, set once installed
+int routedPin = -1;                            // pin the channel input is connected to
+void *channelOwner = nullptr;                  // sensor whose read holds the channel
+
+// Open-drain output on top of the RMT input, so the same pin can send the start pulse
+void configureDataPin(gpio_num_t gpio) {
+  gpio_set_direction(gpio, GPIO_MODE_INPUT_OUTPUT_OD);
+  gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
+  gpio_set_level(gpio, 1);
+}
+}
+
+DhtSensor::DhtSensor(uint8_t pin, const DhtProfile &profile) : _pin(pin), _profile(profile) {}
+
+void DhtSensor::begin() {
+  gpio_num_t gpio = static_cast<gpio_num_t>(_pin);
+  gpio_reset_pin(gpio);
+
+  if (sharedRingbuf == nullptr) {
+    // Configure the RMT receiver with 1 us ticks
+    rmt_config_t config = RMT_DEFAULT_CONFIG_RX(gpio, rxChannel);
+    config.clk_div = 80;                         // 80 MHz APB clock / 80 = 1 us per tick
+    config.mem_block_num = 2;                    // room for the ~42 items of a complete frame
+    config.rx_config.filter_en = true;
+    config.rx_config.filter_ticks_thresh = 200;  // ignore glitches shorter than 2.5 us (APB ticks)
+    config.rx_config.idle_threshold = idleThresholdUs;
+    rmt_config(&config);
+    rmt_driver_install(rxChannel, 1024, 0);
+    rmt_get_ringbuf_handle(rxChannel, &sharedRingbuf);
+    routedPin = _pin;
+  }
+  _driver = sharedRingbuf;
+
+  configureDataPin(gpio);
+
+  // One-shot timer that ends the start pulse
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = &DhtSensor::onStartPulseDone;
+  timerArgs.arg = this;
+  timerArgs.dispatch_method = ESP_TIMER_TASK;
+  timerArgs.name = "dht_start";
+  esp_timer_handle_t timer = nullptr;
+  esp_timer_create(&timerArgs, &timer);
+  _timer = timer;
+}
+
+bool DhtSensor::startRead() {
+  if (_status == Status::BUSY || _timer == nullptr) {
+    return false; // read already in progress or begin() not called
+  }
+  if (channelOwner != nullptr) {
+    return false; // another sensor is reading on the shared channel
+  }
+
+  _captureArmed = false;
+
+#if DHT_LINE_CHECK
+  if (!lineConnected()) {
+    finishRead(Status::NOT_CONNECTED); // fail fast, no start pulse and no timeout
+    return true;
+  }
+#endif
+
+  _status = Status::BUSY;
+  channelOwner = this;
+
+  // Point the shared channel at this sensor (rmt_set_gpio() leaves the pin input-only)
+  if (routedPin != _pin) {
+    rmt_set_gpio(rxChannel, RMT_MODE_RX, static_cast<gpio_num_t>(_pin), false);
+    configureDataPin(static_cast<gpio_num_t>(_pin));
+    routedPin = _pin;
+  }
+
+  // Pull the line low for the start pulse, the timer callback releases it
+  gpio_set_level(static_cast<gpio_num_t>(_pin), 0);
+  esp_timer_start_once(static_cast<esp_timer_handle_t>(_timer), _profile.startPulseUs);
+  return true;
+}
+
+bool DhtSensor::lineConnected() {
+  gpio_num_t gpio = static_cast<gpio_num_t>(_pin);
+
+  // Weak pull-down against the module's pull-up resistor
+  gpio_set_pull_mode(gpio, GPIO_PULLDOWN_ONLY);
+  delayMicroseconds(10);
+  bool connected = gpio_get_level(gpio) == 1;
+  gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
+  return connected;
+}
+
+void DhtSensor::onStartPulseDone(void *arg) {
+  DhtSensor *sensor = static_cast<DhtSensor *>(arg);
+
+  // Release the line and capture the answer
+  gpio_set_level(static_cast<gpio_num_t>(sensor->_pin), 1);
+  rmt_rx_start(rxChannel, true);
+  sensor->_captureStartedAt = esp_timer_get_time();
+  sensor->_captureArmed = true;
+}
+
+DhtSensor::Status DhtSensor::poll() {
+  if (_status != Status::BUSY || !_captureArmed) {
+    return _status; // idle, finished, or still sending the start pulse
+  }
+
+  RingbufHandle_t ringbuf = static_cast<RingbufHandle_t>(_driver);
+  size_t length = 0;
+  rmt_item32_t *items = static_cast<rmt_item32_t *>(xRingbufferReceive(ringbuf, &length, 0));
+
+  if (items != nullptr) {
+    // Shift every high period in as a bit, the last 40 are the frame
+    uint64_t bits = 0;
+    uint8_t bitCount = 0;
+    size_t itemCount = length / sizeof(rmt_item32_t);
+
+    for (size_t i = 0; i < itemCount; i++) {
+      const uint32_t durations[2] = { items[i].duration0, items[i].duration1 };
+      const uint32_t levels[2] = { items[i].level0, items[i].level1 };
+
+      for (uint8_t half = 0; half < 2; half++) {
+        if (levels[half] == 1 && durations[half] > 0 && durations[half] < idleThresholdUs) {
+          bits = (bits << 1) | (durations[half] > oneThresholdUs ? 1 : 0);
+          bitCount++;
+        }
+      }
+    }
+    vRingbufferReturnItem(ringbuf, items);
+    rmt_rx_stop(rxChannel);
+    _captureArmed = false;
+
+    if (bitCount < 40) {
+      finishRead(Status::TIMEOUT); // partial answer
+      return _status;
+    }
+
+    for (uint8_t i = 0; i < 5; i++) {
+      _data[i] = static_cast<uint8_t>(bits >> (8 * (4 - i)));
+    }
+    finishRead(decodeFrame() ? Status::OK : Status::CHECKSUM_ERROR);
+    return _status;
+  }
+
+  if (esp_timer_get_time() - _captureStartedAt > frameTimeoutUs) {
+    rmt_rx_stop(rxChannel);
+    _captureArmed = false;
+    finishRead(Status::TIMEOUT); // no answer from the sensor
+  }
+  return _status;
+}
+
+void DhtSensor::finishRead(Status status) {
+  _sample.ts = millis();
+  switch (status) {
+    case Status::OK:             _sample.status = SampleStatus::OK; break;
+    case Status::CHECKSUM_ERROR: _sample.status = SampleStatus::CHECKSUM_ERROR; break;
+    case Status::NOT_CONNECTED:  _sample.status = SampleStatus::NOT_CONNECTED; break;
+    default:                     _sample.status = SampleStatus::TIMEOUT; break;
+  }
+  if (channelOwner == this) {
+    channelOwner = nullptr; // the shared channel is free for the next sensor
+  }
+  _status = status;
+}
+
+bool DhtSensor::decodeFrame() {
+  if (static_cast<uint8_t>(_data[0] + _data[1] + _data[2] + _data[3]) != _data[4]) {
+    return false;
+  }
+  _profile.decode(_data, _sample);
+  return true;
+}
+
+#endif
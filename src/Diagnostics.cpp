@@ -0,0 +1,251 @@
+/*********************************************************************************************************
+ * Diagnostics
+ *
+ * How It Works:
+ *   1. diagnosticsSnapshot() reads the allocator's heap statistics, the stack watermark of every task
+ *       found by name, and the on-time totals of the radio and the backlight, then prices the on-times
+ *       with the DIAG_CURRENT_* model.
+ *   2. Serial input wakes the loop task through a receive callback, so a command is answered at once
+ *       and the loop never polls the port while idle. diagnosticsPollSerial() collects the bytes into
+ *       a short line buffer and runs the command at the end of the line.
+ *   3. The page labels are part of its cached background (Pages.h). A refresh only draws the values
+ *       whose text changed, each over its background padded out to the column width, so the page does
+ *       not flicker.
+**********************************************************************************************************/
+
+#include "Diagnostics.h"
+
+#if DIAGNOSTICS
+
+#include <stdarg.h>
+#include "Display.h"
+#include "DisplayPower.h"
+#include "DisplayPush.h"
+#include "Layout.h"
+#include "Mesh.h"
+#include "OtaUpdate.h"
+#include "Pages.h"
+#include "WifiLink.h"
+
+namespace {
+const char *taskNames[diagTaskCount] = { "loopTask", "sensor", "display", "uplink", "metrics", "mesh", "ota" };
+
+TaskHandle_t commandTask = nullptr; // woken by serial input
+char commandLine[16];               // command being received
+uint8_t commandLength = 0;
+uint32_t lastPageDraw = 0;
+
+// Wake the loop task to read the serial input
+void serialReceived() {
+  xTaskNotifyGive(commandTask);
+}
+
+// Run one complete command line
+void runCommand(const char *line) {
+  if (strcmp(line, "diag") == 0) {
+    diagnosticsReport(Serial);
+  } else if (line[0] != '\0') {
+    Serial.println("# unknown command, try: diag");
+  }
+}
+
+// Page lines top to bottom, continuing in a second column when the screen is wider than tall; the
+//  task stacks sit between their heading and the radio line
+enum PageLine : uint8_t {
+  LINE_UPTIME,
+  LINE_HEAP_FREE,
+  LINE_HEAP_MIN,
+  LINE_LARGEST,
+  LINE_PSRAM,
+  LINE_STACK_HEADING,
+  LINE_FIRST_TASK,
+  LINE_RADIO = LINE_FIRST_TASK + diagTaskCount,
+  LINE_BACKLIGHT,
+  LINE_DIMMED,
+  LINE_CHARGE,
+  LINE_AVERAGE,
+  LINE_COUNT
+};
+
+// Labels above and below the task lines, those are named after their task
+const char *const topLabels[LINE_FIRST_TASK] = { "Uptime", "Heap free", "Heap min", "Largest", "PSRAM free",
+                                                 "Stack free (bytes)" };
+const char *const bottomLabels[LINE_COUNT - LINE_RADIO] = { "Radio on", "Backlight", "Dimmed", "Charge", "Average" };
+
+const int16_t linePitch = 10;
+const int16_t columnWidth = Layout::pageColumns ? Layout::width / 2 : Layout::width;
+const int16_t valueX = 66; // values right of their labels (11 small font cells)
+const uint8_t linesPerColumn = (Layout::height - Layout::pageTitleHeight) / linePitch;
+static_assert(LINE_COUNT <= (Layout::pageColumns ? 2 : 1) * linesPerColumn, "diagnostics page does not fit the panel");
+
+PageValue values[LINE_COUNT];
+bool refreshDue = true;
+
+int16_t lineX(uint8_t line) {
+  return (line / linesPerColumn) * columnWidth;
+}
+
+int16_t lineY(uint8_t line) {
+  return Layout::pageTitleHeight + (line % linesPerColumn) * linePitch;
+}
+
+// Format one value and draw it if it changed
+void showValue(uint8_t line, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void showValue(uint8_t line, const char *format, ...) {
+  char text[24];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  values[line].draw(lineX(line) + valueX, lineY(line), columnWidth - valueX, text);
+}
+}
+
+void diagnosticsBegin() {
+  commandTask = xTaskGetCurrentTaskHandle();
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+  // USB Serial/JTAG console (the T-Display-S3 default)
+  Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, [](void *, esp_event_base_t, int32_t, void *) { serialReceived(); });
+#else
+  Serial.onReceive(serialReceived);
+#endif
+}
+
+void diagnosticsPollSerial() {
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      commandLine[commandLength] = '\0';
+      runCommand(commandLine);
+      commandLength = 0;
+    } else if (commandLength < sizeof(commandLine) - 1) {
+      commandLine[commandLength++] = c;
+    }
+  }
+}
+
+DiagnosticsSnapshot diagnosticsSnapshot() {
+  DiagnosticsSnapshot snapshot = {};
+  snapshot.uptimeMs = millis();
+  snapshot.freeHeap = ESP.getFreeHeap();
+  snapshot.minFreeHeap = ESP.getMinFreeHeap();
+  snapshot.largestFreeBlock = ESP.getMaxAllocHeap();
+  snapshot.psramSize = ESP.getPsramSize();
+  snapshot.psramFree = ESP.getFreePsram();
+
+  for (uint8_t i = 0; i < diagTaskCount; i++) {
+    TaskHandle_t task = xTaskGetHandle(taskNames[i]);
+    snapshot.tasks[i].name = taskNames[i];
+    snapshot.tasks[i].running = task != nullptr;
+    snapshot.tasks[i].freeBytes = task != nullptr ? uxTaskGetStackHighWaterMark(task) : 0; // bytes on ESP-IDF
+  }
+
+#if MESH_ROLE == MESH_AGGREGATOR
+  snapshot.radioOnMs = snapshot.uptimeMs; // listening for the leaves all the time
+#elif MESH_ROLE == MESH_LEAF
+  snapshot.radioOnMs = meshRadioOnTimeMs(); // a leaf never associates
+#else
+  snapshot.radioOnMs = wifiOnTimeMs();
+#endif
+  snapshot.backlightOnMs = displayStateTimeMs(DisplayPowerState::ON);
+  snapshot.backlightDimMs = displayStateTimeMs(DisplayPowerState::DIMMED);
+
+  // Charge in µA x ms: base draw all the time, plus the backlight and the radio while they are on
+  uint64_t charge = (uint64_t)DIAG_CURRENT_BASE_UA * snapshot.uptimeMs;
+  charge += (uint64_t)DIAG_CURRENT_BACKLIGHT_UA * snapshot.backlightOnMs;
+  charge += (uint64_t)DIAG_CURRENT_BACKLIGHT_UA * BACKLIGHT_DIM / BACKLIGHT_FULL * snapshot.backlightDimMs;
+  charge += (uint64_t)DIAG_CURRENT_RADIO_UA * snapshot.radioOnMs;
+  snapshot.charge_decimAh = charge / 360000000ULL; // 1 mAh = 3.6e9 µA x ms
+  snapshot.current_uA = snapshot.uptimeMs > 0 ? charge / snapshot.uptimeMs : 0;
+  return snapshot;
+}
+
+void diagnosticsReport(Print &out) {
+  DiagnosticsSnapshot snapshot = diagnosticsSnapshot();
+  out.printf("diag,uptime_s=%lu,heap_free=%lu,heap_min=%lu,heap_largest=%lu,psram_size=%lu,psram_free=%lu\n",
+             (unsigned long)(snapshot.uptimeMs / 1000), (unsigned long)snapshot.freeHeap,
+             (unsigned long)snapshot.minFreeHeap, (unsigned long)snapshot.largestFreeBlock,
+             (unsigned long)snapshot.psramSize, (unsigned long)snapshot.psramFree);
+  out.printf("diag,stack_free");
+  for (const TaskStack &task : snapshot.tasks) {
+    if (task.running) {
+      out.printf(",%s=%lu", task.name, (unsigned long)task.freeBytes);
+    }
+  }
+  out.printf("\n");
+  out.printf("diag,radio_on_ms=%lu,backlight_on_ms=%lu,backlight_dim_ms=%lu,charge_mah=%lu.%lu,current_ma=%lu.%lu\n",
+             (unsigned long)snapshot.radioOnMs, (unsigned long)snapshot.backlightOnMs,
+             (unsigned long)snapshot.backlightDimMs, (unsigned long)(snapshot.charge_decimAh / 10),
+             (unsigned long)(snapshot.charge_decimAh % 10), (unsigned long)(snapshot.current_uA / 1000),
+             (unsigned long)(snapshot.current_uA % 1000 / 100));
+#if OTA_UPDATE
+  out.printf("diag,ota_written=%lu,ota_restart_due=%d\n", (unsigned long)otaBytesWritten(), otaRestartDue());
+#endif
+}
+
+void drawDiagnosticsBackground(TFT_eSPI &canvas) {
+  drawPageTitle(canvas, "Diagnostics");
+  canvas.setTextFont(Layout::smallFont);
+  canvas.setTextColor(TFT_WHITE, TFT_BLACK);
+  for (uint8_t line = 0; line < LINE_COUNT; line++) {
+    char label[16];
+    if (line < LINE_FIRST_TASK) {
+      snprintf(label, sizeof(label), "%s", topLabels[line]);
+    } else if (line < LINE_RADIO) {
+      snprintf(label, sizeof(label), " %s", taskNames[line - LINE_FIRST_TASK]);
+    } else {
+      snprintf(label, sizeof(label), "%s", bottomLabels[line - LINE_RADIO]);
+    }
+    canvas.drawString(label, lineX(line), lineY(line));
+  }
+  canvas.setTextFont(Layout::font);
+}
+
+void invalidateDiagnosticsPage() {
+  for (PageValue &value : values) {
+    value.invalidate();
+  }
+  refreshDue = true;
+}
+
+bool diagnosticsPageDirty() {
+  return refreshDue || millis() - lastPageDraw >= DIAG_PAGE_MS;
+}
+
+void drawDiagnosticsPage() {
+  lastPageDraw = millis();
+  refreshDue = false;
+  DiagnosticsSnapshot snapshot = diagnosticsSnapshot();
+
+  displayFence(); // direct drawing, let the queued pushes finish first
+  tft.setTextFont(Layout::smallFont);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  showValue(LINE_UPTIME, "%lu s", (unsigned long)(snapshot.uptimeMs / 1000));
+  showValue(LINE_HEAP_FREE, "%lu", (unsigned long)snapshot.freeHeap);
+  showValue(LINE_HEAP_MIN, "%lu", (unsigned long)snapshot.minFreeHeap);
+  showValue(LINE_LARGEST, "%lu", (unsigned long)snapshot.largestFreeBlock);
+  if (snapshot.psramSize > 0) {
+    showValue(LINE_PSRAM, "%lu/%lu KB", (unsigned long)(snapshot.psramFree / 1024),
+              (unsigned long)(snapshot.psramSize / 1024));
+  } else {
+    showValue(LINE_PSRAM, "none");
+  }
+  for (uint8_t i = 0; i < diagTaskCount; i++) {
+    const TaskStack &task = snapshot.tasks[i];
+    if (task.running) {
+      showValue(LINE_FIRST_TASK + i, "%lu", (unsigned long)task.freeBytes);
+    } else {
+      showValue(LINE_FIRST_TASK + i, "-"); // not in this build, or not started yet
+    }
+  }
+  showValue(LINE_RADIO, "%lu s", (unsigned long)(snapshot.radioOnMs / 1000));
+  showValue(LINE_BACKLIGHT, "%lu s", (unsigned long)(snapshot.backlightOnMs / 1000));
+  showValue(LINE_DIMMED, "%lu s", (unsigned long)(snapshot.backlightDimMs / 1000));
+  showValue(LINE_CHARGE, "%lu.%lu mAh", (unsigned long)(snapshot.charge_decimAh / 10),
+            (unsigned long)(snapshot.charge_decimAh % 10));
+  showValue(LINE_AVERAGE, "%lu.%lu mAh/h", (unsigned long)(snapshot.current_uA / 1000),
+            (unsigned long)(snapshot.current_uA % 1000 / 100));
+  tft.setTextFont(Layout::font);
+}
+
+#endif // DIAGNOSTICS
@@ -0,0 +1,440 @@
+/*********************************************************************************************************
+ * Display
+ *
+ * How It Works:
+ *   1. Each field keeps the text last rendered on the panel and its pixel width.
+ *   2. setField() compares the new text against that cache and sets the field's dirty bit on a change.
+ *   3. updateDynamicElements() walks the dirty bits only. For each dirty field it finds the first
+ *       character that differs, and redraws from that glyph to the end of the wider of the old and new
+ *       text. Unchanged leading glyphs (e.g. "23." in "23.4 C" -> "23.5 C") are never sent again.
+ *   4. In sprite mode (USE_SPRITE_FIELDS) the field is rendered into its sprite and only the changed
+ *       column range of the sprite is pushed; otherwise that range is cleared and redrawn directly.
+ *   5. The static text (title and labels) comes from a 1-bit image cached in flash (STATIC_FRAME_CACHE),
+ *       blitted in a few block writes; it is only rendered glyph by glyph, into RAM, when the label
+ *       layout changed. The blit and one fillRect below it also replace the full-screen clears.
+ *   6. With more than one sensor the status/temperature/humidity fields give way to a compact table,
+ *       one row per sensor with a temperature and a humidity cell. The cells are fields like any other
+ *       (same dirty bits and caches) and share one line sprite, since they are rendered one at a time.
+ *   7. Every position comes from the compile-time Layout (Layout.h), the field rectangles are a constexpr
+ *       table built from it, so the orientation variant costs nothing at run time.
+ *   8. The boot screen comes from the frame cache; when the live page is shown again after another page
+ *       (Pages.h) its static elements come from a full-screen background sprite drawn by drawLiveBackground().
+**********************************************************************************************************/
+
+#include "Display.h"
+#include <array>
+#include <utility>
+#include "DisplayPush.h"
+#include "FixedFormat.h"
+#include "FleetView.h"
+#include "Layout.h"
+#include "Profiler.h"
+#include "SensorArray.h"
+#include "StaticFrame.h"
+#include "TrendGraph.h"
+
+// TFT_eSPI
+TFT_eSPI tft = TFT_eSPI();
+
+namespace {
+const uint8_t namedFieldCount = static_cast<uint8_t>(DisplayField::COUNT);
+const uint8_t tableFieldCount = sensorCount > 1 ? 2 * sensorCount : 0; // temperature + humidity cell per row
+const uint8_t fieldCount = namedFieldCount + tableFieldCount;
+const uint8_t fieldTextSize = deciPairTextSize; // longest field text (the derived pair) plus NUL fits
+static_assert(fieldCount <= 32, "one dirty bit per field");
+static_assert(namedFieldCount == Layout::valueLines, "one layout line per named field");
+static_assert(tableFieldCount == 0 || sensorCount <= Layout::maxTableRows, "sensor table does not fit the layout");
+
+// Screen rectangle of a field: the named fields, then two table cells per sensor
+constexpr Rect fieldArea(uint8_t index) {
+  return index < namedFieldCount
+           ? Layout::field(index)
+           : Layout::tableCell((index - namedFieldCount) / 2, (index - namedFieldCount) % 2);
+}
+
+template <size_t... I>
+constexpr std::array<Rect, fieldCount> makeFieldAreas(std::index_sequence<I...>) {
+  return { { fieldArea(I)... } };
+}
+
+constexpr std::array<Rect, fieldCount> fieldAreas = makeFieldAreas(std::make_index_sequence<fieldCount>());
+
+// One static text label
+struct StaticLabel {
+  int16_t x;
+  int16_t y;
+  const char *text;
+};
+
+constexpr const char *titleText = sensorCount > 1                    ? "- DHT Sensor Array -"
+                                  : sensorTypes[0] == DhtType::Dht22 ? "- DHT22 Sensor Module -"
+                                                                     : "- DHT11 Sensor Module -";
+
+const StaticLabel titleLabels[] = {
+  { 0, Layout::titleY(0), "---------------------------" },
+  { 0, Layout::titleY(1), titleText },
+  { 0, Layout::titleY(2), "---------------------------" },
+};
+
+const StaticLabel fieldLabels[] = {
+  { 0, Layout::labelY(0), "Status:" },
+  { 0, Layout::labelY(1), "Temperature:" },
+  { 0, Layout::labelY(2), "Humidity:" },
+  { 0, Layout::labelY(3), "Dew pt / Heat index:" },
+};
+
+const StaticLabel tableLabels[] = {
+  { 0, Layout::tableY, "#" },
+  { Layout::tableTemperatureX, Layout::tableY, "Temp" },
+  { Layout::tableHumidityX, Layout::tableY, "RH" },
+};
+
+// Render cache of one dynamic field
+struct FieldState {
+  char text[fieldTextSize];   // text currently on the panel
+  int16_t width;              // pixel width of that text
+};
+
+FieldState fields[fieldCount];
+
+#if USE_SPRITE_FIELDS
+TFT_eSprite statusSprite = TFT_eSprite(&tft);      // off-screen buffer for the status line
+TFT_eSprite temperatureSprite = TFT_eSprite(&tft); // off-screen buffer for the temperature line
+TFT_eSprite humiditySprite = TFT_eSprite(&tft);    // off-screen buffer for the humidity line
+TFT_eSprite derivedSprite = TFT_eSprite(&tft);     // off-screen buffer for the dew point / heat index line
+TFT_eSprite tableSprite = TFT_eSprite(&tft);       // off-screen buffer shared by the table cells
+
+TFT_eSprite *namedSprites[namedFieldCount] = { &statusSprite, &temperatureSprite, &humiditySprite, &derivedSprite };
+
+// Off-screen buffer of a field
+TFT_eSprite &fieldSprite(uint8_t index) {
+  return index < namedFieldCount ? *namedSprites[index] : tableSprite;
+}
+#endif
+
+uint32_t dirtyFields = 0;   // one bit per field
+char pendingText[fieldCount][fieldTextSize]; // text to render on the next update
+
+// Pixel width of the first length characters of text
+int16_t prefixWidth(const char *text, size_t length) {
+  char prefix[fieldTextSize];
+  memcpy(prefix, text, length);
+  prefix[length] = '\0';
+  return tft.textWidth(prefix, Layout::font);
+}
+
+template <size_t N>
+void drawLabels(TFT_eSPI &canvas, const StaticLabel (&labels)[N]) {
+  for (const StaticLabel &label : labels) {
+    canvas.drawString(label.text, label.x, label.y);
+  }
+}
+
+// Draw the static text onto the panel or into a frame sprite
+void drawStaticText(TFT_eSPI &canvas) {
+  canvas.setTextFont(Layout::font);
+  canvas.setTextColor(TFT_WHITE, TFT_BLACK);
+  drawLabels(canvas, titleLabels);
+
+  if (tableFieldCount == 0) {
+    drawLabels(canvas, fieldLabels);
+  } else {
+    // Sensor table: column titles and one numbered row per sensor
+    drawLabels(canvas, tableLabels);
+    for (uint8_t i = 0; i < sensorCount; i++) {
+      char number[4];
+      snprintf(number, sizeof(number), "%u", i + 1);
+      canvas.drawString(number, 0, Layout::tableRowY(i));
+    }
+  }
+}
+
+#if STATIC_FRAME_CACHE
+template <size_t N>
+uint32_t hashLabels(uint32_t hash, const StaticLabel (&labels)[N]) {
+  for (const StaticLabel &label : labels) {
+    const uint8_t position[4] = { (uint8_t)label.x, (uint8_t)(label.x >> 8), (uint8_t)label.y, (uint8_t)(label.y >> 8) };
+    for (uint8_t byte : position) {
+      hash = (hash ^ byte) * 16777619u;
+    }
+    for (const char *c = label.text; *c != '\0'; c++) {
+      hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+// FNV-1a over everything the static frame is drawn from
+uint32_t staticFrameKey() {
+  uint32_t hash = 2166136261u;
+  hash = hashLabels(hash, titleLabels);
+  hash = tableFieldCount == 0 ? hashLabels(hash, fieldLabels) : hashLabels(hash, tableLabels);
+  const uint8_t layout[6] = { sensorCount, Layout::rotation, (uint8_t)Layout::width, (uint8_t)(Layout::width >> 8),
+                              (uint8_t)Layout::height, (uint8_t)(Layout::height >> 8) };
+  for (uint8_t byte : layout) {
+    hash = (hash ^ byte) * 16777619u;
+  }
+  return hash;
+}
+
+// Blit the cached frame, rendering and caching it first if the layout changed
+bool drawCachedFrame() {
+  uint32_t key = staticFrameKey();
+  if (blitStaticFrame(key, Layout::width, Layout::staticFrameHeight)) {
+    return true;
+  }
+
+  TFT_eSprite frame = TFT_eSprite(&tft);
+  frame.setColorDepth(1);
+  if (frame.createSprite(Layout::width, Layout::staticFrameHeight) == nullptr) {
+    return false;
+  }
+  frame.fillSprite(TFT_BLACK);
+  drawStaticText(frame);
+  storeStaticFrame(key, frame);
+  frame.deleteSprite();
+  return blitStaticFrame(key, Layout::width, Layout::staticFrameHeight);
+}
+#endif
+
+// Push the changed part of one field
+void renderField(uint8_t index, const char *text) {
+  FieldState &field = fields[index];
+  const Rect &area = fieldAreas[index];
+
+  // First glyph that differs from what is on the panel
+  size_t common = 0;
+  while (text[common] != '\0' && text[common] == field.text[common]) {
+    common++;
+  }
+
+  int16_t width = tft.textWidth(text, Layout::font);
+  int16_t x0 = prefixWidth(text, common);
+  int16_t x1 = width > field.width ? width : field.width; // cover the tail of a longer old text
+  if (x1 > area.w) {
+    x1 = area.w; // never past the field's own rectangle
+  }
+
+#if USE_SPRITE_FIELDS
+  TFT_eSprite &sprite = fieldSprite(index);
+  waitForSprite(sprite);        // the previous push of a shared sprite may still be in flight
+  sprite.fillSprite(TFT_BLACK); // clearing happens in RAM, not on the screen
+  sprite.drawString(text, 0, 0);
+  if (x1 > x0) {
+    queueSpritePush(sprite, area.x + x0, area.y, x0, 0, x1 - x0, area.h); // one window write for the changed glyphs
+  }
+#else
+  displayFence(); // the trend graph may still be in flight
+  if (x1 > x0) {
+    tft.fillRect(area.x + x0, area.y, x1 - x0, area.h, TFT_BLACK); // clear the changed glyphs only
+    tft.drawString(text + common, area.x + x0, area.y);
+  }
+#endif
+
+  strncpy(field.text, text, fieldTextSize - 1);
+  field.text[fieldTextSize - 1] = '\0';
+  field.width = width;
+}
+}
+
+// Function to initialize the TFT display
+void initDisplay() {
+  tft.init();
+  tft.setRotation(Layout::rotation);      // adjust rotation (0 & 2 portrait | 1 & 3 landscape)
+  tft.setTextFont(Layout::font);          // set the font (you can experiment with different fonts)
+  tft.setTextColor(TFT_WHITE, TFT_BLACK); // set text colour (white) and background colour (black)
+
+#if USE_SPRITE_FIELDS
+  // Create the off-screen buffers for the dynamic fields, each as wide as its widest field
+  for (uint8_t i = 0; i < fieldCount; i++) {
+    TFT_eSprite &sprite = fieldSprite(i);
+    if (sprite.created()) {
+      continue; // shared by the table cells
+    }
+    int16_t width = 0;
+    for (uint8_t j = i; j < fieldCount; j++) {
+      if (&fieldSprite(j) == &sprite && fieldAreas[j].w > width) {
+        width = fieldAreas[j].w;
+      }
+    }
+    sprite.setColorDepth(16);
+    sprite.setAttribute(PSRAM_ENABLE, false); // keep the small field buffers in internal RAM
+    sprite.createSprite(width, Layout::lineHeight);
+    sprite.setTextFont(Layout::font);
+    sprite.setTextColor(TFT_WHITE, TFT_BLACK);
+  }
+#endif
+
+  // Create the trend graph next to the values
+  initTrendGraph();
+
+  // Sprite pushes run in the background from here on
+  displayPushBegin();
+}
+
+// Function to draw static elements on the TFT screen
+void drawStaticElements() {
+  displayFence();                         // direct drawing, let the queued pushes finish first
+
+  // Draw static text or elements (the frame blit clears everything above the graph legend)
+#if STATIC_FRAME_CACHE
+  if (drawCachedFrame()) {
+    tft.fillRect(0, Layout::staticFrameHeight, Layout::width, Layout::height - Layout::staticFrameHeight, TFT_BLACK);
+  } else
+#endif
+  {
+    tft.fillScreen(TFT_BLACK);            // clear the screen
+    drawStaticText(tft);
+  }
+  tft.setTextFont(Layout::font);          // set the font
+  tft.setTextColor(TFT_WHITE, TFT_BLACK); // set text color and background
+
+  // Trend graph legend, the graph itself is pushed with the dynamic elements
+  drawTrendGraphFrame();
+  invalidateLiveScreen();
+}
+
+// Function to draw the static elements into a page background sprite
+void drawLiveBackground(TFT_eSPI &canvas) {
+  drawStaticText(canvas);
+  drawTrendLegend(canvas, Layout::legend.x, Layout::legend.y, GRAPH_SPAN_MINUTES);
+}
+
+// Function to mark everything over the static elements for a redraw
+void invalidateLiveScreen() {
+  invalidateTrendGraph();
+#if MESH_ROLE == MESH_AGGREGATOR
+  invalidateFleetView(); // drawn over the legend
+#endif
+#if PROFILER
+  invalidateProfilerOverlay();
+#endif
+
+  // The screen is blank below the labels now, so every field has to be drawn in full again
+  for (uint8_t i = 0; i < fieldCount; i++) {
+    fields[i].text[0] = '\0';
+    fields[i].width = 0;
+    if (pendingText[i][0] != '\0') {
+      dirtyFields |= 1UL << i;
+    }
+  }
+}
+
+namespace {
+// Set the text of a field by index, marks it dirty if it changed
+void setFieldText(uint8_t index, const char *text) {
+  if (strncmp(pendingText[index], text, fieldTextSize - 1) == 0) {
+    return; // unchanged, nothing to push
+  }
+
+  strncpy(pendingText[index], text, fieldTextSize - 1);
+  pendingText[index][fieldTextSize - 1] = '\0';
+
+  if (strcmp(pendingText[index], fields[index].text) != 0) {
+    dirtyFields |= 1UL << index;
+  } else {
+    dirtyFields &= ~(1UL << index); // changed back to what is already on the panel
+  }
+}
+
+// Format a sample into its row of the sensor table
+void showTableRow(const SensorSample &sample) {
+  uint8_t index = namedFieldCount + 2 * sample.sensor;
+  if (!sample.valid()) {
+    setFieldText(index, "N/C"); // not connected or malfunctioning
+    setFieldText(index + 1, "");
+    return;
+  }
+
+  DeciText text;
+  formatDeci(text, sample.t_decidegC, 'C');
+  setFieldText(index, text);
+  formatDeci(text, static_cast<int16_t>(sample.rh_decipct), '%');
+  setFieldText(index + 1, text);
+}
+}
+
+// Function to set the text of a dynamic field
+void setField(DisplayField field, const char *text) {
+  setFieldText(static_cast<uint8_t>(field), text);
+}
+
+// Function to format a sensor sample into the dynamic fields
+void showSample(const SensorSample &sample) {
+  if (tableFieldCount > 0) {
+    showTableRow(sample);
+    return;
+  }
+
+  if (!sample.valid()) {
+    // Sensor not connected or malfunctioning
+    setField(DisplayField::STATUS, "DISCONNECTED");
+    setField(DisplayField::TEMPERATURE, "N/A");
+    setField(DisplayField::HUMIDITY, "N/A");
+    setField(DisplayField::DERIVED, "N/A");
+    return;
+  }
+
+  DeciText text;
+  setField(DisplayField::STATUS, "CONNECTED");
+  formatDeci(text, sample.t_decidegC, 'C');
+  setField(DisplayField::TEMPERATURE, text);
+  formatDeci(text, static_cast<int16_t>(sample.rh_decipct), '%');
+  setField(DisplayField::HUMIDITY, text);
+}
+
+// Function to format the derived metrics into their field ("<dew point> / <heat index> C")
+void showDerived(const DerivedSample &derived) {
+  if (tableFieldCount > 0) {
+    return; // no room in the sensor table
+  }
+
+  char text[deciPairTextSize];
+  DeciText dewPoint, heatIndex;
+  formatDeci(dewPoint, derived.dewPoint_decidegC);
+  formatDeci(heatIndex, derived.heatIndex_decidegC, 'C');
+  snprintf(text, sizeof(text), "%s / %s", dewPoint, heatIndex);
+  setField(DisplayField::DERIVED, text);
+}
+
+bool displayDirty() {
+#if PROFILER
+  if (profilerOverlayVisible()) {
+    return dirtyFields != 0 || profilerOverlayDirty();
+  }
+#endif
+#if MESH_ROLE == MESH_AGGREGATOR
+  return dirtyFields != 0 || fleetViewDirty(); // the fleet view takes the graph's place
+#else
+  return dirtyFields != 0 || trendGraphDirty();
+#endif
+}
+
+// Function to update dynamic elements on the TFT screen
+void updateDynamicElements() {
+  while (dirtyFields != 0) {
+    uint8_t index = __builtin_ctz(dirtyFields); // lowest dirty field
+    dirtyFields &= dirtyFields - 1;
+    renderField(index, pendingText[index]);
+  }
+
+#if PROFILER
+  if (profilerOverlayVisible()) {
+    // The overlay covers the graph, it keeps collecting columns off-screen
+    if (profilerOverlayDirty()) {
+      drawProfilerOverlay();
+    }
+    return;
+  }
+#endif
+
+#if MESH_ROLE == MESH_AGGREGATOR
+  if (fleetViewDirty()) {
+    drawFleetView();
+  }
+#else
+  if (trendGraphDirty()) {
+    updateTrendGraph();
+  }
+#endif
+}
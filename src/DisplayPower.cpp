@@ -0,0 +1,121 @@
+/*********************************************************************************************************
+ * Display Power
+ *
+ * How It Works:
+ *   1. displayPowerBegin() attaches the backlight pin (TFT_BL) to an LEDC channel at full duty.
+ *   2. Every displayActivity() records the time. updateDisplayPower() compares the idle time against
+ *       BACKLIGHT_DIM_MS and DISPLAY_SLEEP_MS and steps ON -> DIMMED -> ASLEEP.
+ *   3. The loop task blocks for at most displayPowerTimeoutMs(), so a step is applied on time even when
+ *       no sample arrives in between.
+ *   4. Going to sleep fences the queued pushes and sends SLPIN; waking sends SLPOUT and waits the
+ *       120 ms the controller needs before the next command, then turns the backlight back on.
+**********************************************************************************************************/
+
+#include "DisplayPower.h"
+#include "Display.h"
+#include "DisplayPush.h"
+
+namespace {
+DisplayPowerState state = DisplayPowerState::ON;
+uint32_t lastActivity = 0;
+uint32_t stateSince = 0;     // millis() when the current state was entered
+uint32_t stateTotal[3] = {}; // time spent in each state before the current one, for the diagnostics
+
+// Set the backlight PWM duty
+void setBacklight(uint8_t duty) {
+#ifdef TFT_BL
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ledcWrite(TFT_BL, duty);
+#else
+  ledcWrite(BACKLIGHT_LEDC_CHANNEL, duty);
+#endif
+#else
+  (void)duty;
+#endif
+}
+
+void enterState(DisplayPowerState next) {
+  if (next == state) {
+    return;
+  }
+
+  if (state == DisplayPowerState::ASLEEP) {
+    tft.writecommand(ST7789_SLPOUT);
+    delay(120); // sleep out time before the next command
+  }
+
+  switch (next) {
+    case DisplayPowerState::ON:
+      setBacklight(BACKLIGHT_FULL);
+      break;
+    case DisplayPowerState::DIMMED:
+      setBacklight(BACKLIGHT_DIM);
+      break;
+    case DisplayPowerState::ASLEEP:
+      setBacklight(0);
+      displayFence(); // the last pushes land before the panel stops
+      tft.writecommand(ST7789_SLPIN);
+      break;
+  }
+  uint32_t now = millis();
+  stateTotal[static_cast<uint8_t>(state)] += now - stateSince;
+  stateSince = now;
+  state = next;
+}
+}
+
+void displayPowerBegin() {
+#ifdef TFT_BL
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ledcAttach(TFT_BL, BACKLIGHT_PWM_FREQ, 8);
+#else
+  ledcSetup(BACKLIGHT_LEDC_CHANNEL, BACKLIGHT_PWM_FREQ, 8);
+  ledcAttachPin(TFT_BL, BACKLIGHT_LEDC_CHANNEL);
+#endif
+#endif
+  setBacklight(BACKLIGHT_FULL);
+  state = DisplayPowerState::ON;
+  lastActivity = millis();
+  stateSince = 0; // on since boot
+}
+
+void displayActivity() {
+  lastActivity = millis();
+  enterState(DisplayPowerState::ON);
+}
+
+void updateDisplayPower() {
+  uint32_t idle = millis() - lastActivity;
+  if (DISPLAY_SLEEP_MS > 0 && idle >= DISPLAY_SLEEP_MS) {
+    enterState(DisplayPowerState::ASLEEP);
+  } else if (BACKLIGHT_DIM_MS > 0 && idle >= BACKLIGHT_DIM_MS && state == DisplayPowerState::ON) {
+    enterState(DisplayPowerState::DIMMED);
+  }
+}
+
+bool displayAwake() {
+  return state != DisplayPowerState::ASLEEP;
+}
+
+DisplayPowerState displayPowerState() {
+  return state;
+}
+
+uint32_t displayStateTimeMs(DisplayPowerState which) {
+  uint32_t total = stateTotal[static_cast<uint8_t>(which)];
+  return which == state ? total + (millis() - stateSince) : total;
+}
+
+uint32_t displayPowerTimeoutMs() {
+  uint32_t idle = millis() - lastActivity;
+  uint32_t due = UINT32_MAX;
+  if (state == DisplayPowerState::ON && BACKLIGHT_DIM_MS > 0) {
+    due = BACKLIGHT_DIM_MS;
+  } else if (state != DisplayPowerState::ASLEEP && DISPLAY_SLEEP_MS > 0) {
+    due = DISPLAY_SLEEP_MS;
+  }
+  if (due == UINT32_MAX) {
+    return due;
+  }
+  return idle >= due ? 0 : due - idle;
+}
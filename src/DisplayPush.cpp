@@ -0,0 +1,157 @@
+/*********************************************************************************************************
+ * Display Push Pipeline
+ *
+ * How It Works (display task):
+ *   1. queueSpritePush() records the window in an SPSC job queue, tags it with a sequence number and
+ *       notifies the display task. The sprite's last sequence number is remembered.
+ *   2. The display task pushes the jobs in order and counts them as completed, giving a semaphore
+ *       after each one.
+ *   3. waitForSprite() waits until the sprite's last job has completed, displayFence() until all have.
+ *   A full job queue just waits for one completion, so a burst of pushes never gets dropped.
+ *
+ * How It Works (DMA):
+ *   The sprite rows of the window are handed to pushImageDMA() (full width, so the rows are one
+ *    contiguous block) and the transaction stays open until the fence closes it.
+**********************************************************************************************************/
+
+#include "DisplayPush.h"
+#include "Display.h"
+#include "SpscQueue.h"
+
+#if DISPLAY_ASYNC_PUSH && !defined(ESP32_DMA)
+#define DISPLAY_PUSH_TASK 1
+#else
+#define DISPLAY_PUSH_TASK 0
+#endif
+
+namespace {
+#if DISPLAY_PUSH_TASK
+// One window push
+struct PushJob {
+  TFT_eSprite *sprite;
+  int16_t tx, ty, sx, sy, sw, sh;
+};
+
+// Last queued job of a sprite
+struct SpriteSequence {
+  const TFT_eSprite *sprite;
+  uint32_t sequence;
+};
+
+const uint8_t trackedSprites = 8;                       // field sprites, table sprite, trend graph
+
+SpscQueue<PushJob, DISPLAY_PUSH_QUEUE> jobs;            // loop() -> display task
+TaskHandle_t pushTask = nullptr;
+SemaphoreHandle_t completedSignal = nullptr;            // given after every completed job
+std::atomic<uint32_t> completed{0};                     // jobs pushed to the panel
+uint32_t submitted = 0;                                 // jobs queued (loop side only)
+SpriteSequence sequences[trackedSprites] = {};
+
+void displayTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    PushJob job;
+    while (jobs.pop(job)) {
+      job.sprite->pushSprite(job.tx, job.ty, job.sx, job.sy, job.sw, job.sh);
+      completed.fetch_add(1, std::memory_order_release);
+      xSemaphoreGive(completedSignal);
+    }
+  }
+}
+
+// Block until at least sequence jobs have completed
+void waitForCompleted(uint32_t sequence) {
+  while ((int32_t)(completed.load(std::memory_order_acquire) - sequence) < 0) {
+    xSemaphoreTake(completedSignal, portMAX_DELAY);
+  }
+}
+
+void rememberSequence(const TFT_eSprite *sprite, uint32_t sequence) {
+  SpriteSequence *free = nullptr;
+  for (SpriteSequence &entry : sequences) {
+    if (entry.sprite == sprite) {
+      entry.sequence = sequence;
+      return;
+    }
+    if (entry.sprite == nullptr && free == nullptr) {
+      free = &entry;
+    }
+  }
+  if (free != nullptr) {
+    *free = { sprite, sequence };
+  } else {
+    waitForCompleted(sequence); // more sprites than tracked, fall back to a synchronous push
+  }
+}
+#elif DISPLAY_ASYNC_PUSH
+bool transactionOpen = false;                           // pushImageDMA() transaction in progress
+#endif
+}
+
+void displayPushBegin() {
+#if DISPLAY_PUSH_TASK
+  completedSignal = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK, nullptr, DISPLAY_TASK_PRIORITY,
+                          &pushTask, DISPLAY_TASK_CORE);
+#elif DISPLAY_ASYNC_PUSH
+  tft.initDMA();
+#endif
+}
+
+void queueSpritePush(TFT_eSprite &sprite, int16_t tx, int16_t ty, int16_t sx, int16_t sy, int16_t sw,
+                     int16_t sh) {
+#if DISPLAY_PUSH_TASK
+  while (!jobs.push({ &sprite, tx, ty, sx, sy, sw, sh })) {
+    waitForCompleted(completed.load(std::memory_order_acquire) + 1); // queue full
+  }
+  submitted++;
+  rememberSequence(&sprite, submitted);
+  xTaskNotifyGive(pushTask);
+#elif DISPLAY_ASYNC_PUSH
+  int16_t left = tx - sx;
+  if (left != 0 || sprite.width() != tft.width()) {
+    // Rows of a narrower window are not contiguous in the sprite, push it synchronously
+    displayFence();
+    sprite.pushSprite(tx, ty, sx, sy, sw, sh);
+    return;
+  }
+
+  if (!transactionOpen) {
+    tft.startWrite();
+    transactionOpen = true;
+  }
+  uint16_t *pixels = static_cast<uint16_t *>(sprite.getPointer()) + sy * sprite.width();
+  tft.pushImageDMA(0, ty, sprite.width(), sh, pixels); // waits for the previous transfer first
+#else
+  sprite.pushSprite(tx, ty, sx, sy, sw, sh);
+#endif
+}
+
+void waitForSprite(const TFT_eSprite &sprite) {
+#if DISPLAY_PUSH_TASK
+  for (const SpriteSequence &entry : sequences) {
+    if (entry.sprite == &sprite) {
+      waitForCompleted(entry.sequence);
+      return;
+    }
+  }
+#elif DISPLAY_ASYNC_PUSH
+  (void)sprite;
+  displayFence(); // one DMA transfer in flight at most
+#else
+  (void)sprite;
+#endif
+}
+
+void displayFence() {
+#if DISPLAY_PUSH_TASK
+  waitForCompleted(submitted);
+#elif DISPLAY_ASYNC_PUSH
+  if (transactionOpen) {
+    tft.dmaWait();
+    tft.endWrite();
+    transactionOpen = false;
+  }
+#endif
+}
@@ -0,0 +1,147 @@
+/*********************************************************************************************************
+ * Flash Log
+ *
+ * How It Works:
+ *   1. append() encodes the sample as a delta against the previous record of the page, or as a key
+ *       record when the page is empty or a delta does not fit in a byte.
+ *   2. A record that does not fit in the rest of the page pads the page, writes it with one append
+ *       and starts a new page with a key record.
+ *   3. The file handle stays open between pages; each page write is followed by a flush, so the page
+ *       is durable once it leaves the buffer.
+**********************************************************************************************************/
+
+#include "FlashLog.h"
+
+#include <FS.h>
+#include <LittleFS.h>
+
+namespace {
+const char *logPath = "/samples.bin";
+const char *backupPath = "/samples.old";
+const uint8_t keyTag = 0xFF;
+const uint8_t padTag = 0x00;
+const uint8_t keyLength = 9;
+const uint8_t deltaLength = 3;
+
+File logFile;
+}
+
+FlashLog flashLog;
+
+bool FlashLog::begin() {
+  _mounted = LittleFS.begin(true); // format the partition on first use
+  if (_mounted) {
+    logFile = LittleFS.open(logPath, FILE_APPEND);
+  }
+  return _mounted && logFile;
+}
+
+void FlashLog::append(uint32_t seconds, int16_t t_decidegC, uint16_t rh_decipct) {
+  if (!_mounted) {
+    return;
+  }
+
+  int32_t dt = (int32_t)(seconds - _lastSeconds);
+  int32_t dT = t_decidegC - _lastT;
+  int32_t dRh = (int32_t)rh_decipct - _lastRh;
+
+  if (_used > 0 && dt >= 1 && dt <= 254 && dT >= -128 && dT <= 127 && dRh >= -128 && dRh <= 127) {
+    uint8_t record[deltaLength] = { (uint8_t)dt, (uint8_t)(int8_t)dT, (uint8_t)(int8_t)dRh };
+    if (_used + deltaLength <= LOG_PAGE_SIZE) {
+      appendRecord(record, deltaLength);
+    } else {
+      writePage(); // page full, the sample becomes the next page's key record
+      append(seconds, t_decidegC, rh_decipct);
+      return;
+    }
+  } else {
+    if (_used + keyLength > LOG_PAGE_SIZE) {
+      writePage();
+    }
+    uint8_t record[keyLength] = {
+      keyTag,
+      (uint8_t)seconds, (uint8_t)(seconds >> 8), (uint8_t)(seconds >> 16), (uint8_t)(seconds >> 24),
+      (uint8_t)t_decidegC, (uint8_t)((uint16_t)t_decidegC >> 8),
+      (uint8_t)rh_decipct, (uint8_t)(rh_decipct >> 8)
+    };
+    appendRecord(record, keyLength);
+  }
+
+  _lastSeconds = seconds;
+  _lastT = t_decidegC;
+  _lastRh = rh_decipct;
+}
+
+void FlashLog::appendRecord(const uint8_t *record, uint8_t length) {
+  memcpy(&_page[_used], record, length);
+  _used += length;
+}
+
+void FlashLog::writePage() {
+  if (_used == 0 || !logFile) {
+    return;
+  }
+
+  // Pad and append the page in one write
+  memset(&_page[_used], padTag, LOG_PAGE_SIZE - _used);
+  logFile.write(_page, LOG_PAGE_SIZE);
+  logFile.flush();
+  _used = 0;
+
+  // Rotate once the log is full
+  if (logFile.size() >= LOG_MAX_BYTES) {
+    logFile.close();
+    LittleFS.remove(backupPath);
+    LittleFS.rename(logPath, backupPath);
+    logFile = LittleFS.open(logPath, FILE_APPEND);
+  }
+}
+
+void FlashLog::flush() {
+  writePage();
+}
+
+void FlashLog::dump(Print &out) {
+  if (!_mounted) {
+    return;
+  }
+
+  out.println("timestamp,temperature,humidity");
+  const char *paths[] = { backupPath, logPath };
+  for (const char *path : paths) {
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file) {
+      continue;
+    }
+
+    uint8_t page[LOG_PAGE_SIZE];
+    while (file.read(page, LOG_PAGE_SIZE) == LOG_PAGE_SIZE) {
+      uint32_t seconds = 0;
+      int16_t t = 0;
+      uint16_t rh = 0;
+      uint16_t i = 0;
+
+      while (i < LOG_PAGE_SIZE && page[i] != padTag) {
+        if (page[i] == keyTag) {
+          if (i + keyLength > LOG_PAGE_SIZE) {
+            break;
+          }
+          seconds = page[i + 1] | (page[i + 2] << 8) | (page[i + 3] << 16) | ((uint32_t)page[i + 4] << 24);
+          t = (int16_t)(page[i + 5] | (page[i + 6] << 8));
+          rh = page[i + 7] | (page[i + 8] << 8);
+          i += keyLength;
+        } else {
+          if (i + deltaLength > LOG_PAGE_SIZE) {
+            break;
+          }
+          seconds += page[i];
+          t += (int8_t)page[i + 1];
+          rh += (int8_t)page[i + 2];
+          i += deltaLength;
+        }
+        out.printf("%lu,%d,%u\n", (unsigned long)seconds, t, rh);
+      }
+    }
+    file.close();
+  }
+}
@@ -0,0 +1,131 @@
+/*********************************************************************************************************
+ * Fleet View
+ *
+ * How It Works:
+ *   1. Each redraw copies the node table slot by slot (meshNode(), one short lock each) and folds the
+ *       online pairs with a valid reading into min/sum/max.
+ *   2. The summary lines go at the top of the area, then one line per pair: node id (last three MAC
+ *       bytes), sensor index, reading and seconds since the last frame. Offline pairs are greyed.
+ *   3. meshChangeCount() tells whether anything arrived since the last redraw.
+**********************************************************************************************************/
+
+#include "FleetView.h"
+
+#if MESH_ROLE == MESH_AGGREGATOR
+
+#include "Display.h"
+#include "DisplayPush.h"
+#include "FixedFormat.h"
+#include "Layout.h"
+#include "Mesh.h"
+
+namespace {
+const int16_t lineHeight = 10;
+const uint32_t refreshMs = 10 * MESH_VIEW_MS; // ages and offline pairs without new frames
+
+bool forced = true;
+uint32_t drawnChange = 0;
+uint32_t lastDraw = 0;
+
+// Min/mean/max of one channel over the online pairs
+struct Spread {
+  int16_t minimum = INT16_MAX;
+  int16_t maximum = INT16_MIN;
+  int32_t sum = 0;
+
+  void add(int16_t value) {
+    minimum = value < minimum ? value : minimum;
+    maximum = value > maximum ? value : maximum;
+    sum += value;
+  }
+};
+
+void printSpread(const char *label, const Spread &spread, uint16_t count) {
+  DeciText minimum, mean, maximum;
+  formatDeci(minimum, spread.minimum);
+  formatDeci(mean, static_cast<int16_t>(spread.sum / count));
+  formatDeci(maximum, spread.maximum);
+  tft.printf("%-3s%-6s%-6s%s", label, minimum, mean, maximum);
+}
+}
+
+void invalidateFleetView() {
+  forced = true;
+}
+
+bool fleetViewDirty() {
+  uint32_t now = millis();
+  if (forced) {
+    return true;
+  }
+  return now - lastDraw >= (meshChangeCount() != drawnChange ? MESH_VIEW_MS : refreshMs);
+}
+
+void drawFleetView() {
+  uint32_t now = millis();
+  forced = false;
+  drawnChange = meshChangeCount();
+  lastDraw = now;
+
+  // Summary over the online pairs
+  uint16_t pairs = 0;
+  uint16_t online = 0;
+  Spread temperature, humidity;
+  MeshNode node;
+  for (uint8_t slot = 0; slot < MESH_MAX_NODES; slot++) {
+    if (!meshNode(slot, node)) {
+      continue;
+    }
+    pairs++;
+    if (meshNodeOnline(node, now) && node.sample.valid()) {
+      online++;
+      temperature.add(node.sample.t_decidegC);
+      humidity.add(static_cast<int16_t>(node.sample.rh_decipct));
+    }
+  }
+
+  const Rect &area = Layout::overlay;
+  int16_t y = area.y;
+  displayFence();
+  tft.fillRect(area.x, area.y, area.w, area.h, TFT_BLACK);
+  tft.setTextFont(Layout::smallFont);
+  tft.setTextColor(TFT_YELLOW, TFT_BLACK);
+  tft.setCursor(area.x, y);
+  tft.printf("FLEET %u/%u online", online, pairs);
+
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  if (online > 0) {
+    tft.setCursor(area.x, y += lineHeight);
+    tft.print("   min   mean  max");
+    tft.setCursor(area.x, y += lineHeight);
+    printSpread("T", temperature, online);
+    tft.setCursor(area.x, y += lineHeight);
+    printSpread("RH", humidity, online);
+  }
+
+  // One line per pair, as many as fit
+  y += lineHeight / 2;
+  for (uint8_t slot = 0; slot < MESH_MAX_NODES && y + 2 * lineHeight <= area.bottom(); slot++) {
+    if (!meshNode(slot, node)) {
+      continue;
+    }
+    bool up = meshNodeOnline(node, now);
+    tft.setTextColor(up ? TFT_WHITE : TFT_DARKGREY, TFT_BLACK);
+    tft.setCursor(area.x, y += lineHeight);
+    tft.printf("%02x%02x%02x/%u ", node.mac[3], node.mac[4], node.mac[5], node.sample.sensor);
+    if (!node.sample.valid()) {
+      tft.print("N/C  ");
+    } else {
+      DeciText t, rh;
+      formatDeci(t, node.sample.t_decidegC);
+      formatDeci(rh, static_cast<int16_t>(node.sample.rh_decipct));
+      tft.printf("%-5s %-5s", t, rh);
+    }
+    tft.printf(" %lus", (unsigned long)((now - node.sample.ts) / 1000));
+  }
+
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.setTextFont(Layout::font);
+}
+
+#endif
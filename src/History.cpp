@@ -0,0 +1,191 @@
+/*********************************************************************************************************
+ * Sample History
+ *
+ * How It Works:
+ *   1. append() writes the sample into the hot ring at its sequence number and adds it to the
+ *       aggregate of its window. The first sample of a window resets that window's aggregate, and its
+ *       time becomes the base the 16-bit offsets of the window are measured from. A sample more than
+ *       65535 s after that base (an outage of over 18 hours) skips the sequence numbers left in the
+ *       window and starts the next one, so an offset never wraps.
+ *   2. When the hot ring is full, its oldest window (always contiguous, as both rings are multiples of
+ *       the window size) is copied to the cold ring column by column and the hot start moves on.
+ *   3. The cold ring overwrites its oldest window once it is full. The aggregate ring holds one window
+ *       more than both tiers together, so every sample still held has its window's aggregate.
+ *   4. A mutex (created in begin()) is held by append() while the rings change, readers on other tasks
+ *       take it through lock()/unlock().
+**********************************************************************************************************/
+
+#include "History.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+static_assert((HISTORY_WINDOW & (HISTORY_WINDOW - 1)) == 0, "HISTORY_WINDOW must be a power of two");
+static_assert(HISTORY_HOT_SAMPLES % HISTORY_WINDOW == 0, "HISTORY_HOT_SAMPLES must be a multiple of HISTORY_WINDOW");
+static_assert(HISTORY_COLD_SAMPLES % HISTORY_WINDOW == 0, "HISTORY_COLD_SAMPLES must be a multiple of HISTORY_WINDOW");
+
+History history;
+
+void HistoryAggregate::add(int16_t t, uint16_t rh, uint32_t ts) {
+  if (count == 0) {
+    startTs = ts;
+    tMin = tMax = t;
+    rhMin = rhMax = rh;
+  } else {
+    tMin = t < tMin ? t : tMin;
+    tMax = t > tMax ? t : tMax;
+    rhMin = rh < rhMin ? rh : rhMin;
+    rhMax = rh > rhMax ? rh : rhMax;
+  }
+  endTs = ts;
+  tSum += t;
+  rhSum += rh;
+  count++;
+}
+
+void HistoryAggregate::merge(const HistoryAggregate &other) {
+  if (other.count == 0) {
+    return;
+  }
+  if (count == 0) {
+    *this = other;
+    return;
+  }
+  tMin = other.tMin < tMin ? other.tMin : tMin;
+  tMax = other.tMax > tMax ? other.tMax : tMax;
+  rhMin = other.rhMin < rhMin ? other.rhMin : rhMin;
+  rhMax = other.rhMax > rhMax ? other.rhMax : rhMax;
+  startTs = other.startTs < startTs ? other.startTs : startTs;
+  endTs = other.endTs > endTs ? other.endTs : endTs;
+  tSum += other.tSum;
+  rhSum += other.rhSum;
+  count += other.count;
+}
+
+bool History::begin() {
+  _mutex = xSemaphoreCreateMutex();
+
+  const uint32_t windowsNeeded = (HISTORY_HOT_SAMPLES + HISTORY_COLD_SAMPLES) / HISTORY_WINDOW + 1;
+  const uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+
+  _coldT = static_cast<int16_t *>(heap_caps_malloc(HISTORY_COLD_SAMPLES * sizeof(int16_t), caps));
+  _coldRh = static_cast<uint16_t *>(heap_caps_malloc(HISTORY_COLD_SAMPLES * sizeof(uint16_t), caps));
+  _coldTs = static_cast<uint16_t *>(heap_caps_malloc(HISTORY_COLD_SAMPLES * sizeof(uint16_t), caps));
+  _windows = static_cast<HistoryAggregate *>(heap_caps_calloc(windowsNeeded, sizeof(HistoryAggregate), caps));
+
+  if (_coldT && _coldRh && _coldTs && _windows) {
+    _coldCapacity = HISTORY_COLD_SAMPLES;
+    _windowCapacity = windowsNeeded;
+    return true;
+  }
+
+  // No PSRAM: keep the hot window only, with its aggregates in internal RAM
+  heap_caps_free(_coldT);
+  heap_caps_free(_coldRh);
+  heap_caps_free(_coldTs);
+  heap_caps_free(_windows);
+  _coldT = nullptr;
+  _coldRh = nullptr;
+  _coldTs = nullptr;
+  _coldCapacity = 0;
+  _windowCapacity = HISTORY_HOT_SAMPLES / HISTORY_WINDOW + 1;
+  _windows = static_cast<HistoryAggregate *>(calloc(_windowCapacity, sizeof(HistoryAggregate)));
+  if (_windows == nullptr) {
+    _windowCapacity = 0;
+  }
+  return false;
+}
+
+uint32_t History::firstIndex() const {
+  return _hotStart > _coldCapacity ? _hotStart - _coldCapacity : 0;
+}
+
+void History::append(const SensorSample &sample) {
+  if (!sample.valid() || _windows == nullptr) {
+    return;
+  }
+
+  lock();
+  // A gap the 16-bit offset cannot span closes the window early, its unused tail stays empty
+  uint32_t ts = sample.ts / 1000;
+  if (_end % HISTORY_WINDOW != 0 && ts - _windows[windowSlot(_end)].startTs > UINT16_MAX) {
+    _end += HISTORY_WINDOW - _end % HISTORY_WINDOW;
+  }
+  if (_end - _hotStart == HISTORY_HOT_SAMPLES) {
+    spillOldestWindow();
+  }
+
+  // Start a new window on its first sample
+  HistoryAggregate &window = _windows[windowSlot(_end)];
+  if (_end % HISTORY_WINDOW == 0) {
+    window = HistoryAggregate();
+  }
+  window.add(sample.t_decidegC, sample.rh_decipct, ts);
+
+  uint32_t slot = _end % HISTORY_HOT_SAMPLES;
+  _hotT[slot] = sample.t_decidegC;
+  _hotRh[slot] = sample.rh_decipct;
+  _hotTs[slot] = static_cast<uint16_t>(ts - window.startTs);
+  _end++;
+  unlock();
+}
+
+void History::spillOldestWindow() {
+  if (_coldCapacity > 0) {
+    uint32_t from = _hotStart % HISTORY_HOT_SAMPLES;
+    uint32_t to = _hotStart % _coldCapacity;
+    memcpy(&_coldT[to], &_hotT[from], HISTORY_WINDOW * sizeof(int16_t));
+    memcpy(&_coldRh[to], &_hotRh[from], HISTORY_WINDOW * sizeof(uint16_t));
+    memcpy(&_coldTs[to], &_hotTs[from], HISTORY_WINDOW * sizeof(uint16_t));
+  }
+  _hotStart += HISTORY_WINDOW;
+}
+
+bool History::get(uint32_t index, HistorySample &out) const {
+  if (index >= _end || index < firstIndex() || index % HISTORY_WINDOW >= _windows[windowSlot(index)].count) {
+    return false; // not held, or the empty tail of a window closed early
+  }
+
+  uint16_t offset;
+  if (index >= _hotStart) {
+    uint32_t slot = index % HISTORY_HOT_SAMPLES;
+    out.t_decidegC = _hotT[slot];
+    out.rh_decipct = _hotRh[slot];
+    offset = _hotTs[slot];
+  } else {
+    uint32_t slot = index % _coldCapacity;
+    out.t_decidegC = _coldT[slot];
+    out.rh_decipct = _coldRh[slot];
+    offset = _coldTs[slot];
+  }
+  out.ts = _windows[windowSlot(index)].startTs + offset;
+  return true;
+}
+
+HistoryAggregate History::summarize(uint32_t windows) const {
+  HistoryAggregate result;
+  if (_end == 0) {
+    return result;
+  }
+
+  // Walk back from the current window, stopping at the oldest one still held
+  uint32_t newest = (_end - 1) / HISTORY_WINDOW;
+  uint32_t oldest = firstIndex() / HISTORY_WINDOW;
+  for (uint32_t i = 0; i < windows && i <= newest - oldest; i++) {
+    result.merge(_windows[(newest - i) % _windowCapacity]);
+  }
+  return result;
+}
+
+void History::lock() const {
+  if (_mutex != nullptr) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+  }
+}
+
+void History::unlock() const {
+  if (_mutex != nullptr) {
+    xSemaphoreGive(_mutex);
+  }
+}
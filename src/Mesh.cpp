@@ -0,0 +1,365 @@
+/*********************************************************************************************************
+ * ESP-NOW Sensor Mesh
+ *
+ * How It Works:
+ *   Leaf:
+ *   1. meshBegin() initializes the radio in station mode (never associated), ESP-NOW and the broadcast
+ *       peer, then stops the radio again and starts a low-priority send task.
+ *   2. meshSend() turns the reading into a frame, pushes it into an SPSC queue and notifies the task.
+ *   3. The task starts the radio, broadcasts everything queued (MESH_REPEATS copies each, waiting for
+ *       the send callback between copies) and stops the radio. Readings that arrive while the radio
+ *       is up go out in the same wake.
+ *   Aggregator:
+ *   1. meshBegin() starts the radio on MESH_CHANNEL and registers the receive callback.
+ *   2. The callback (Wi-Fi task) checks the frame's size, magic and version, pushes it with the sender's
+ *       MAC into an SPSC queue and notifies the loop task.
+ *   3. meshPoll() (loop task) drains the queue into the node table. A frame whose sequence number is
+ *       not newer than the slot's latest one, within MESH_SEQUENCE_WINDOW, is a repeat and dropped; a
+ *       much older number means the leaf rebooted and is accepted. A new pair takes a free slot, or
+ *       the slot of the pair that has been silent the longest once that one is offline.
+ *   4. The table is guarded by a mutex, so other tasks (metrics server) can copy slots out of it.
+**********************************************************************************************************/
+
+#include "Mesh.h"
+
+#if MESH_ROLE != MESH_OFF
+
+#include <atomic>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <WiFi.h>
+#include "SpscQueue.h"
+
+#if MESH_ROLE == MESH_LEAF && (TELEMETRY || METRICS_SERVER)
+#error "A mesh leaf has no Wi-Fi uplink, the aggregator carries TELEMETRY and METRICS_SERVER"
+#endif
+
+namespace {
+const uint8_t broadcastAddress[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+std::atomic<uint32_t> framesSent{0};
+std::atomic<uint32_t> framesReceived{0};
+std::atomic<uint32_t> duplicateFrames{0};
+std::atomic<uint32_t> droppedFrames{0};
+
+// Start ESP-NOW on MESH_CHANNEL, the radio is left running
+bool startEspNow() {
+  WiFi.mode(WIFI_STA);
+  esp_wifi_set_channel(MESH_CHANNEL, WIFI_SECOND_CHAN_NONE);
+  return esp_now_init() == ESP_OK;
+}
+
+#if MESH_ROLE == MESH_LEAF
+RTC_DATA_ATTR uint16_t nextSequence = 0; // kept across deep sleep, so repeats stay distinguishable
+
+SpscQueue<MeshFrame, MESH_QUEUE> outbox; // loop() -> send task
+TaskHandle_t sendTask = nullptr;
+SemaphoreHandle_t sendDone = nullptr;    // given by the send callback
+bool espNowReady = false;
+uint32_t radioOnSince = 0;
+uint32_t radioOnTotal = 0;
+std::atomic<bool> radioOn{false};
+
+void onSent(const uint8_t *, esp_now_send_status_t) {
+  xSemaphoreGive(sendDone);
+}
+
+MeshFrame makeFrame(const SensorSample &sample) {
+  MeshFrame frame;
+  frame.magic = meshMagic;
+  frame.version = meshVersion;
+  frame.sequence = nextSequence++;
+  frame.sensor = sample.sensor;
+  frame.status = static_cast<uint8_t>(sample.status);
+  frame.t_decidegC = sample.valid() ? sample.t_decidegC : 0;
+  frame.rh_decipct = sample.valid() ? sample.rh_decipct : 0;
+  return frame;
+}
+
+void radioUp() {
+  radioOnSince = millis();
+  radioOn.store(true, std::memory_order_relaxed);
+  esp_wifi_start();
+  esp_wifi_set_channel(MESH_CHANNEL, WIFI_SECOND_CHAN_NONE); // the channel is lost with the stop
+}
+
+void radioDown() {
+  esp_wifi_stop();
+  radioOnTotal += millis() - radioOnSince;
+  radioOn.store(false, std::memory_order_relaxed);
+}
+
+// One-time ESP-NOW setup, leaves the radio stopped
+bool initLeaf() {
+  if (espNowReady) {
+    return true;
+  }
+  sendDone = xSemaphoreCreateBinary();
+  radioOnSince = millis();
+  if (!startEspNow()) {
+    radioDown();
+    return false;
+  }
+  esp_now_register_send_cb(onSent);
+
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, broadcastAddress, sizeof(broadcastAddress));
+  peer.channel = 0; // the current channel
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  espNowReady = esp_now_add_peer(&peer) == ESP_OK;
+  radioDown();
+  return espNowReady;
+}
+
+// Broadcast the copies of one frame, the radio has to be up
+bool broadcastFrame(const MeshFrame &frame) {
+  bool sent = false;
+  for (uint8_t copy = 0; copy < MESH_REPEATS; copy++) {
+    if (esp_now_send(broadcastAddress, reinterpret_cast<const uint8_t *>(&frame), sizeof(frame)) != ESP_OK) {
+      continue;
+    }
+    xSemaphoreTake(sendDone, pdMS_TO_TICKS(MESH_SEND_TIMEOUT_MS));
+    framesSent.fetch_add(1, std::memory_order_relaxed);
+    sent = true;
+  }
+  return sent;
+}
+
+void sendLoop(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    radioUp();
+    MeshFrame frame;
+    while (outbox.pop(frame)) {
+      if (!broadcastFrame(frame)) {
+        droppedFrames.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    radioDown();
+  }
+}
+#endif
+
+#if MESH_ROLE == MESH_AGGREGATOR
+// Frame as taken off the air
+struct ReceivedFrame {
+  uint8_t mac[6];
+  MeshFrame frame;
+};
+
+SpscQueue<ReceivedFrame, MESH_QUEUE> inbox; // Wi-Fi task -> loop task
+TaskHandle_t wakeTask = nullptr;
+MeshNode nodes[MESH_MAX_NODES];
+bool slotUsed[MESH_MAX_NODES];
+SemaphoreHandle_t nodesMutex = nullptr;
+std::atomic<uint32_t> changeCount{0};
+
+void take(const uint8_t *mac, const uint8_t *data, int length) {
+  ReceivedFrame received;
+  if (length != (int)sizeof(MeshFrame)) {
+    return; // not one of ours
+  }
+  memcpy(&received.frame, data, sizeof(MeshFrame));
+  if (received.frame.magic != meshMagic || received.frame.version != meshVersion) {
+    return;
+  }
+  memcpy(received.mac, mac, sizeof(received.mac));
+  if (!inbox.push(received)) {
+    droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  xTaskNotifyGive(wakeTask);
+}
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+void onReceived(const esp_now_recv_info_t *info, const uint8_t *data, int length) {
+  take(info->src_addr, data, length);
+}
+#else
+void onReceived(const uint8_t *mac, const uint8_t *data, int length) {
+  take(mac, data, length);
+}
+#endif
+
+// Slot of a (node, sensor) pair, -1 if it has none
+int8_t findSlot(const ReceivedFrame &received) {
+  for (uint8_t i = 0; i < MESH_MAX_NODES; i++) {
+    if (slotUsed[i] && nodes[i].sample.sensor == received.frame.sensor &&
+        memcmp(nodes[i].mac, received.mac, sizeof(received.mac)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Slot for a new pair: a free one, else the one silent the longest if it is offline, -1 if none
+int8_t freeSlot(uint32_t now) {
+  int8_t stalest = -1;
+  for (uint8_t i = 0; i < MESH_MAX_NODES; i++) {
+    if (!slotUsed[i]) {
+      return i;
+    }
+    if (!meshNodeOnline(nodes[i], now) && (stalest < 0 || now - nodes[i].sample.ts > now - nodes[stalest].sample.ts)) {
+      stalest = i;
+    }
+  }
+  return stalest;
+}
+
+// Fold one frame into the node table (mutex held), true if it was a new reading
+bool accept(const ReceivedFrame &received, uint32_t now) {
+  int8_t slot = findSlot(received);
+  if (slot >= 0) {
+    MeshNode &node = nodes[slot];
+    int16_t age = static_cast<int16_t>(node.sequence - received.frame.sequence);
+    if (age >= 0 && age < MESH_SEQUENCE_WINDOW) {
+      node.duplicates++;
+      duplicateFrames.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } else {
+    slot = freeSlot(now);
+    if (slot < 0) {
+      droppedFrames.fetch_add(1, std::memory_order_relaxed); // every slot belongs to an online pair
+      return false;
+    }
+    MeshNode &node = nodes[slot];
+    memcpy(node.mac, received.mac, sizeof(node.mac));
+    node.frames = 0;
+    node.duplicates = 0;
+    slotUsed[slot] = true;
+  }
+
+  MeshNode &node = nodes[slot];
+  node.sequence = received.frame.sequence;
+  node.sample.t_decidegC = received.frame.t_decidegC;
+  node.sample.rh_decipct = received.frame.rh_decipct;
+  node.sample.ts = now;
+  node.sample.status = static_cast<SampleStatus>(received.frame.status);
+  node.sample.sensor = received.frame.sensor;
+  node.frames++;
+  framesReceived.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+#endif
+}
+
+void meshBegin() {
+#if MESH_ROLE == MESH_LEAF
+  if (initLeaf()) {
+    xTaskCreatePinnedToCore(sendLoop, "mesh", MESH_TASK_STACK, nullptr, 1, &sendTask, 0);
+  }
+#else
+  wakeTask = xTaskGetCurrentTaskHandle();
+  nodesMutex = xSemaphoreCreateMutex();
+  WiFi.setSleep(false); // listen all the time, leaves do not know when the aggregator would be awake
+  if (startEspNow()) {
+    esp_now_register_recv_cb(onReceived);
+  }
+#endif
+}
+
+void meshSend(const SensorSample &sample) {
+#if MESH_ROLE == MESH_LEAF
+  if (sendTask == nullptr) {
+    return;
+  }
+  if (!outbox.push(makeFrame(sample))) {
+    droppedFrames.fetch_add(1, std::memory_order_relaxed); // send task stuck behind the radio
+    return;
+  }
+  xTaskNotifyGive(sendTask);
+#else
+  (void)sample;
+#endif
+}
+
+bool meshSendNow(const SensorSample &sample) {
+#if MESH_ROLE == MESH_LEAF
+  if (!initLeaf()) {
+    return false;
+  }
+  radioUp();
+  bool sent = broadcastFrame(makeFrame(sample));
+  radioDown();
+  return sent;
+#else
+  (void)sample;
+  return false;
+#endif
+}
+
+bool meshPoll() {
+#if MESH_ROLE == MESH_AGGREGATOR
+  if (inbox.empty()) {
+    return false;
+  }
+
+  bool changed = false;
+  uint32_t now = millis();
+  ReceivedFrame received;
+  xSemaphoreTake(nodesMutex, portMAX_DELAY);
+  while (inbox.pop(received)) {
+    changed |= accept(received, now);
+  }
+  xSemaphoreGive(nodesMutex);
+  if (changed) {
+    changeCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  return changed;
+#else
+  return false;
+#endif
+}
+
+bool meshNode(uint8_t slot, MeshNode &out) {
+#if MESH_ROLE == MESH_AGGREGATOR
+  if (slot >= MESH_MAX_NODES || nodesMutex == nullptr) {
+    return false;
+  }
+  xSemaphoreTake(nodesMutex, portMAX_DELAY);
+  bool used = slotUsed[slot];
+  if (used) {
+    out = nodes[slot];
+  }
+  xSemaphoreGive(nodesMutex);
+  return used;
+#else
+  (void)slot;
+  (void)out;
+  return false;
+#endif
+}
+
+bool meshNodeOnline(const MeshNode &node, uint32_t now) {
+  return now - node.sample.ts < MESH_NODE_TIMEOUT_MS;
+}
+
+uint32_t meshChangeCount() {
+#if MESH_ROLE == MESH_AGGREGATOR
+  return changeCount.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+MeshStats meshStats() {
+  MeshStats stats;
+  stats.framesSent = framesSent.load(std::memory_order_relaxed);
+  stats.framesReceived = framesReceived.load(std::memory_order_relaxed);
+  stats.duplicates = duplicateFrames.load(std::memory_order_relaxed);
+  stats.dropped = droppedFrames.load(std::memory_order_relaxed);
+  return stats;
+}
+
+uint32_t meshRadioOnTimeMs() {
+#if MESH_ROLE == MESH_LEAF
+  return radioOnTotal + (radioOn.load(std::memory_order_relaxed) ? millis() - radioOnSince : 0);
+#else
+  return 0;
+#endif
+}
+
+#endif
@@ -0,0 +1,410 @@
+/*********************************************************************************************************
+ * Metrics Server
+ *
+ * How It Works:
+ *   1. The server task acquires the Wi-Fi link once and keeps it, then accepts one client at a time.
+ *       Requests are short, so several collectors scraping every second are simply served in turn.
+ *   2. Only the request line is kept; the headers are read through a small line buffer and dropped.
+ *   3. The response is written through a ResponseWriter: snprintf into the preallocated buffer, and
+ *       whenever the next piece does not fit, the buffer goes out to the socket and is reused.
+ *   4. /api/samples copies METRICS_CHUNK samples at a time out of the history under its lock, then
+ *       formats them with the lock released, so loop() never waits for the network. A page that
+ *       overlaps samples dropped by the ring while it was being sent continues at the oldest one held.
+ *   5. loop() publishes every reading into a small per-sensor table (mutex, one struct copy), the
+ *       server formats /metrics from that table and the history aggregates.
+ *
+ * Notes:
+ *   - The task runs below the sensor and display tasks. The DHT frames are captured by the RMT
+ *      peripheral, so network traffic on core 0 cannot shift the read cadence.
+ *   - WiFiServer has no blocking accept, the task polls every METRICS_POLL_MS while idle.
+**********************************************************************************************************/
+
+#include "MetricsServer.h"
+
+#if METRICS_SERVER
+
+#include <atomic>
+#include <stdarg.h>
+#include <WiFi.h>
+#include "Alarm.h"
+#include "FixedFormat.h"
+#include "History.h"
+#include "Mesh.h"
+#include "SensorArray.h"
+#include "WifiLink.h"
+
+namespace {
+// Latest reading of one sensor
+struct PublishedSample {
+  SensorSample sample;
+  DerivedSample derived;
+  uint32_t receivedAt; // millis() when it was published
+  bool seen;           // false until the sensor's first reading
+};
+
+PublishedSample latest[sensorCount];
+SemaphoreHandle_t latestMutex = nullptr;
+std::atomic<uint32_t> requestCount{0};
+
+WiFiServer server(METRICS_PORT);
+char responseBuffer[METRICS_BUFFER_SIZE]; // preallocated, reused by every response
+
+// Streams formatted text to a client through the preallocated buffer
+class ResponseWriter {
+public:
+  explicit ResponseWriter(WiFiClient &client) : _client(client) {}
+
+  // Append formatted text, sending the buffer first if the text does not fit behind it
+  void printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int length = append(format, args);
+    va_end(args);
+    if (length >= 0) {
+      return;
+    }
+
+    flush();
+    va_start(args, format);
+    append(format, args); // an empty buffer holds any single piece this server writes
+    va_end(args);
+  }
+
+  // Send what is buffered
+  void flush() {
+    if (_length > 0 && _client.connected()) {
+      _client.write(reinterpret_cast<const uint8_t *>(responseBuffer), _length);
+    }
+    _length = 0;
+  }
+
+private:
+  // Format into the free part of the buffer, returns the length or -1 if it did not fit
+  int append(const char *format, va_list args) {
+    size_t space = sizeof(responseBuffer) - _length;
+    int length = vsnprintf(responseBuffer + _length, space, format, args);
+    if (length < 0 || (size_t)length >= space) {
+      responseBuffer[_length] = '\0';
+      return -1;
+    }
+    _length += length;
+    return length;
+  }
+
+  WiFiClient &_client;
+  size_t _length = 0;
+};
+
+// Read one line into line (without the line end), returns its length
+size_t readLine(WiFiClient &client, char *line, size_t size) {
+  size_t length = client.readBytesUntil('\n', line, size - 1);
+  if (length > 0 && line[length - 1] == '\r') {
+    length--;
+  }
+  line[length] = '\0';
+  return length;
+}
+
+// Value of an unsigned query parameter, or fallback if the query does not have it
+uint32_t queryValue(const char *query, const char *name, uint32_t fallback) {
+  size_t nameLength = strlen(name);
+  const char *p = query;
+  while (p != nullptr && *p != '\0') {
+    if (strncmp(p, name, nameLength) == 0 && p[nameLength] == '=') {
+      return strtoul(p + nameLength + 1, nullptr, 10);
+    }
+    p = strchr(p, '&');
+    p = p != nullptr ? p + 1 : nullptr;
+  }
+  return fallback;
+}
+
+void writeHeader(ResponseWriter &out, const char *status, const char *contentType) {
+  out.printf("HTTP/1.1 %s\r\nContent-Type: %s\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n",
+             status, contentType);
+}
+
+// Write a value in tenths as a plain number
+void writeDeci(ResponseWriter &out, const char *name, const char *labels, int16_t tenths) {
+  DeciText text;
+  formatDeci(text, tenths);
+  out.printf("%s{%s} %s\n", name, labels, text);
+}
+
+#if MESH_ROLE == MESH_AGGREGATOR
+// Latest reading of every online (node, sensor) pair of the mesh, slot by slot
+void writeFleet(ResponseWriter &out, uint32_t now) {
+  char labels[40];
+  MeshNode node;
+  out.printf("# HELP dht_fleet_temperature_celsius Latest temperature of a mesh leaf.\n"
+             "# TYPE dht_fleet_temperature_celsius gauge\n");
+  for (uint8_t slot = 0; slot < MESH_MAX_NODES; slot++) {
+    if (meshNode(slot, node) && meshNodeOnline(node, now) && node.sample.valid()) {
+      snprintf(labels, sizeof(labels), "node=\"%02x%02x%02x\",sensor=\"%u\"", node.mac[3], node.mac[4],
+               node.mac[5], node.sample.sensor);
+      writeDeci(out, "dht_fleet_temperature_celsius", labels, node.sample.t_decidegC);
+    }
+  }
+  out.printf("# HELP dht_fleet_humidity_percent Latest relative humidity of a mesh leaf.\n"
+             "# TYPE dht_fleet_humidity_percent gauge\n");
+  for (uint8_t slot = 0; slot < MESH_MAX_NODES; slot++) {
+    if (meshNode(slot, node) && meshNodeOnline(node, now) && node.sample.valid()) {
+      snprintf(labels, sizeof(labels), "node=\"%02x%02x%02x\",sensor=\"%u\"", node.mac[3], node.mac[4],
+               node.mac[5], node.sample.sensor);
+      writeDeci(out, "dht_fleet_humidity_percent", labels, static_cast<int16_t>(node.sample.rh_decipct));
+    }
+  }
+
+  MeshStats stats = meshStats();
+  out.printf("# HELP dht_fleet_frames_total Mesh frames by outcome.\n# TYPE dht_fleet_frames_total counter\n"
+             "dht_fleet_frames_total{outcome=\"accepted\"} %lu\n"
+             "dht_fleet_frames_total{outcome=\"duplicate\"} %lu\n"
+             "dht_fleet_frames_total{outcome=\"dropped\"} %lu\n",
+             (unsigned long)stats.framesReceived, (unsigned long)stats.duplicates, (unsigned long)stats.dropped);
+}
+#endif
+
+void writeMetrics(ResponseWriter &out) {
+  writeHeader(out, "200 OK", "text/plain; version=0.0.4");
+
+  // Copy the table so the mutex is not held while writing to the socket
+  PublishedSample readings[sensorCount];
+  xSemaphoreTake(latestMutex, portMAX_DELAY);
+  memcpy(readings, latest, sizeof(readings));
+  xSemaphoreGive(latestMutex);
+  uint32_t now = millis();
+
+  char labels[24];
+  out.printf("# HELP dht_sensor_up 1 if the last read of the sensor succeeded.\n# TYPE dht_sensor_up gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    out.printf("dht_sensor_up{sensor=\"%u\"} %d\n", i, readings[i].seen && readings[i].sample.valid() ? 1 : 0);
+  }
+  out.printf("# HELP dht_sample_age_seconds Time since the last reading of the sensor.\n"
+             "# TYPE dht_sample_age_seconds gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (readings[i].seen) {
+      out.printf("dht_sample_age_seconds{sensor=\"%u\"} %lu\n", i,
+                 (unsigned long)((now - readings[i].receivedAt) / 1000));
+    }
+  }
+  out.printf("# HELP dht_temperature_celsius Latest temperature reading.\n# TYPE dht_temperature_celsius gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (readings[i].seen && readings[i].sample.valid()) {
+      snprintf(labels, sizeof(labels), "sensor=\"%u\"", i);
+      writeDeci(out, "dht_temperature_celsius", labels, readings[i].sample.t_decidegC);
+    }
+  }
+  out.printf("# HELP dht_humidity_percent Latest relative humidity reading.\n# TYPE dht_humidity_percent gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (readings[i].seen && readings[i].sample.valid()) {
+      snprintf(labels, sizeof(labels), "sensor=\"%u\"", i);
+      writeDeci(out, "dht_humidity_percent", labels, static_cast<int16_t>(readings[i].sample.rh_decipct));
+    }
+  }
+
+  out.printf("# HELP dht_dew_point_celsius Dew point of the latest reading.\n# TYPE dht_dew_point_celsius gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (readings[i].seen && readings[i].sample.valid()) {
+      snprintf(labels, sizeof(labels), "sensor=\"%u\"", i);
+      writeDeci(out, "dht_dew_point_celsius", labels, readings[i].derived.dewPoint_decidegC);
+    }
+  }
+  out.printf("# HELP dht_heat_index_celsius Heat index of the latest reading.\n# TYPE dht_heat_index_celsius gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (readings[i].seen && readings[i].sample.valid()) {
+      snprintf(labels, sizeof(labels), "sensor=\"%u\"", i);
+      writeDeci(out, "dht_heat_index_celsius", labels, readings[i].derived.heatIndex_decidegC);
+    }
+  }
+  out.printf("# HELP dht_absolute_humidity_grams_per_cubic_meter Water vapour density of the latest reading.\n"
+             "# TYPE dht_absolute_humidity_grams_per_cubic_meter gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (readings[i].seen && readings[i].sample.valid()) {
+      snprintf(labels, sizeof(labels), "sensor=\"%u\"", i);
+      writeDeci(out, "dht_absolute_humidity_grams_per_cubic_meter", labels,
+                static_cast<int16_t>(readings[i].derived.absHumidity_decigm3));
+    }
+  }
+
+#if ALARMS
+  // Alarm state, and the response times the alarm paths achieved so far
+  out.printf("# HELP dht_alarm_active 1 while the alarm condition holds.\n# TYPE dht_alarm_active gauge\n");
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    uint8_t active = activeAlarms(i);
+    for (uint8_t kind = 0; kind < static_cast<uint8_t>(AlarmKind::COUNT); kind++) {
+      out.printf("dht_alarm_active{sensor=\"%u\",kind=\"%s\"} %d\n", i,
+                 alarmKindName(static_cast<AlarmKind>(kind)), (active >> kind) & 1);
+    }
+  }
+  AlarmStats alarms = alarmStats();
+  out.printf("# HELP dht_alarms_raised_total Alarms raised since boot.\n# TYPE dht_alarms_raised_total counter\n"
+             "dht_alarms_raised_total %lu\n", (unsigned long)alarms.raised);
+  out.printf("# HELP dht_alarm_latency_max_microseconds Worst time from the end of a read to the alarm response.\n"
+             "# TYPE dht_alarm_latency_max_microseconds gauge\n"
+             "dht_alarm_latency_max_microseconds{path=\"pin\"} %lu\n"
+             "dht_alarm_latency_max_microseconds{path=\"screen\"} %lu\n",
+             (unsigned long)alarms.maxPinLatencyUs, (unsigned long)alarms.maxScreenLatencyUs);
+  out.printf("# HELP dht_alarm_screen_over_budget_total Alerts drawn later than the screen budget.\n"
+             "# TYPE dht_alarm_screen_over_budget_total counter\ndht_alarm_screen_over_budget_total %lu\n",
+             (unsigned long)alarms.overBudget);
+#endif
+
+  // Aggregates of the primary sensor over the newest windows of the history
+  history.lock();
+  HistoryAggregate summary = history.summarize(METRICS_SUMMARY_WINDOWS);
+  uint32_t stored = history.size();
+  history.unlock();
+
+  out.printf("# HELP dht_history_stored_samples Samples held by the history store.\n"
+             "# TYPE dht_history_stored_samples gauge\ndht_history_stored_samples %lu\n",
+             (unsigned long)stored);
+  out.printf("# HELP dht_history_summary_samples Samples in the summary window.\n"
+             "# TYPE dht_history_summary_samples gauge\ndht_history_summary_samples %lu\n",
+             (unsigned long)summary.count);
+  if (summary.count > 0) {
+    out.printf("# HELP dht_history_summary_span_seconds Time covered by the summary window.\n"
+               "# TYPE dht_history_summary_span_seconds gauge\ndht_history_summary_span_seconds %lu\n",
+               (unsigned long)(summary.endTs - summary.startTs));
+    out.printf("# HELP dht_history_temperature_celsius Temperature over the summary window.\n"
+               "# TYPE dht_history_temperature_celsius gauge\n");
+    writeDeci(out, "dht_history_temperature_celsius", "stat=\"min\"", summary.tMin);
+    writeDeci(out, "dht_history_temperature_celsius", "stat=\"max\"", summary.tMax);
+    writeDeci(out, "dht_history_temperature_celsius", "stat=\"mean\"", summary.tMean());
+    out.printf("# HELP dht_history_humidity_percent Relative humidity over the summary window.\n"
+               "# TYPE dht_history_humidity_percent gauge\n");
+    writeDeci(out, "dht_history_humidity_percent", "stat=\"min\"", static_cast<int16_t>(summary.rhMin));
+    writeDeci(out, "dht_history_humidity_percent", "stat=\"max\"", static_cast<int16_t>(summary.rhMax));
+    writeDeci(out, "dht_history_humidity_percent", "stat=\"mean\"", static_cast<int16_t>(summary.rhMean()));
+  }
+
+#if MESH_ROLE == MESH_AGGREGATOR
+  writeFleet(out, now);
+#endif
+
+  out.printf("# HELP dht_uptime_seconds Time since boot.\n# TYPE dht_uptime_seconds counter\n"
+             "dht_uptime_seconds %lu\n", (unsigned long)(now / 1000));
+  out.printf("# HELP dht_http_requests_total Requests served by this server.\n"
+             "# TYPE dht_http_requests_total counter\ndht_http_requests_total %lu\n",
+             (unsigned long)requestCount.load(std::memory_order_relaxed));
+}
+
+void writeSamples(ResponseWriter &out, const char *query) {
+  history.lock();
+  uint32_t first = history.firstIndex();
+  uint32_t end = history.endIndex();
+  history.unlock();
+
+  // Default page: the newest METRICS_SAMPLES_MAX samples
+  uint32_t limit = queryValue(query, "limit", METRICS_SAMPLES_MAX);
+  limit = limit < METRICS_SAMPLES_MAX ? limit : METRICS_SAMPLES_MAX;
+  uint32_t index = queryValue(query, "since", end - first > limit ? end - limit : first);
+  index = index < first ? first : (index > end ? end : index);
+  uint32_t stop = end - index > limit ? index + limit : end;
+
+  writeHeader(out, "200 OK", "application/json");
+  out.printf("{\"device\":\"%s\",\"first\":%lu,\"samples\":[", DEVICE_NAME, (unsigned long)first);
+
+  bool firstSample = true;
+  while (index < stop) {
+    // Copy one batch under the lock, format it without
+    HistorySample batch[METRICS_CHUNK];
+    uint8_t count = 0;
+    history.lock();
+    if (index < history.firstIndex()) {
+      index = history.firstIndex(); // the ring moved on while the page was going out
+    }
+    for (; count < METRICS_CHUNK && index < stop; index++) {
+      count += history.get(index, batch[count]) ? 1 : 0; // skips the empty tail of a window closed by a gap
+    }
+    history.unlock();
+
+    for (uint8_t i = 0; i < count; i++) {
+      out.printf("%s[%lu,%d,%u]", firstSample ? "" : ",", (unsigned long)batch[i].ts, batch[i].t_decidegC,
+                 batch[i].rh_decipct);
+      firstSample = false;
+    }
+  }
+  out.printf("],\"next\":%lu}", (unsigned long)index);
+}
+
+// Answer one request
+void serveClient(WiFiClient &client) {
+  client.setTimeout(METRICS_TIMEOUT_MS / 1000 + 1);
+
+  // Request line, e.g. "GET /api/samples?since=100 HTTP/1.1", then skip the headers
+  char request[128];
+  char header[96];
+  readLine(client, request, sizeof(request));
+  while (readLine(client, header, sizeof(header)) > 0) {
+  }
+
+  ResponseWriter out(client);
+  char *path = strchr(request, ' ');
+  char *version = path != nullptr ? strchr(path + 1, ' ') : nullptr;
+  if (path == nullptr || version == nullptr) {
+    writeHeader(out, "400 Bad Request", "text/plain");
+  } else if (strncmp(request, "GET ", 4) != 0) {
+    writeHeader(out, "405 Method Not Allowed", "text/plain");
+  } else {
+    *version = '\0';
+    path++;
+    char *query = strchr(path, '?');
+    if (query != nullptr) {
+      *query++ = '\0';
+    }
+
+    if (strcmp(path, "/metrics") == 0) {
+      writeMetrics(out);
+    } else if (strcmp(path, "/api/samples") == 0) {
+      writeSamples(out, query);
+    } else {
+      writeHeader(out, "404 Not Found", "text/plain");
+    }
+  }
+  out.flush();
+  requestCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void serverLoop(void *) {
+  // Hold the link for as long as the server runs, retry while the access point is missing
+  while (!wifiAcquire(METRICS_CONNECT_TIMEOUT_MS)) {
+    vTaskDelay(pdMS_TO_TICKS(METRICS_RETRY_MS));
+  }
+  server.begin();
+  server.setNoDelay(true);
+
+  for (;;) {
+    WiFiClient client = server.available();
+    if (!client) {
+      vTaskDelay(pdMS_TO_TICKS(METRICS_POLL_MS));
+      continue;
+    }
+    client.setNoDelay(true);
+    serveClient(client);
+    client.stop();
+  }
+}
+}
+
+void metricsServerBegin() {
+  latestMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(serverLoop, "metrics", METRICS_TASK_STACK, nullptr, 1, nullptr, 0);
+}
+
+void metricsPublish(const SensorSample &sample, const DerivedSample &derived) {
+  if (latestMutex == nullptr || sample.sensor >= sensorCount) {
+    return;
+  }
+  xSemaphoreTake(latestMutex, portMAX_DELAY);
+  latest[sample.sensor].sample = sample;
+  latest[sample.sensor].derived = derived;
+  latest[sample.sensor].receivedAt = millis();
+  latest[sample.sensor].seen = true;
+  xSemaphoreGive(latestMutex);
+}
+
+uint32_t metricsRequestCount() {
+  return requestCount.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,164 @@
+/*********************************************************************************************************
+ * OTA Update
+ *
+ * How It Works:
+ *   1. The task acquires the Wi-Fi link, GETs the image and reads the Content-Length from the headers.
+ *   2. The first chunk holds the image's app description: an image of the running firmware ends the
+ *       check there, before anything is written.
+ *   3. esp_ota_begin() with sequential writes erases nothing up front. Every chunk goes to
+ *       esp_ota_write(), which erases the sector as it is reached, then the task sleeps for
+ *       OTA_CHUNK_PAUSE_MS; the TCP window holds the sender back in the meantime.
+ *   4. esp_ota_end() checks the image (checksum and appended SHA-256) before it is set to boot. Any error
+ *       aborts the update, the running image stays the boot partition and the next check starts over.
+ *   5. A finished update only sets a flag; the restart is left to loop(), which knows when it is quiet.
+**********************************************************************************************************/
+
+#include "OtaUpdate.h"
+
+#if OTA_UPDATE
+
+#include <atomic>
+#include <esp_ota_ops.h>
+#include <WiFi.h>
+#include "WifiLink.h"
+
+#if MESH_ROLE == MESH_LEAF
+#error "A mesh leaf has no Wi-Fi uplink, OTA_UPDATE needs an associated station"
+#endif
+
+namespace {
+// The app description follows the image header and the first segment header
+const size_t descriptionOffset = sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t);
+
+std::atomic<bool> restartDue{false};
+std::atomic<uint32_t> bytesWritten{0};
+uint8_t chunk[OTA_CHUNK];      // one step of the image, static so the task stack stays small
+WiFiClient client;
+
+const esp_app_desc_t *runningDescription() {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  return esp_app_get_description();
+#else
+  return esp_ota_get_app_description();
+#endif
+}
+
+// Send the request and skip the headers, returns the image size (0 on an error)
+size_t requestImage() {
+  if (!client.connect(OTA_HOST, OTA_PORT)) {
+    return 0;
+  }
+
+  char header[192];
+  int headerLength = snprintf(header, sizeof(header), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                              OTA_PATH, OTA_HOST);
+  client.write(reinterpret_cast<const uint8_t *>(header), headerLength);
+
+  char line[96];
+  client.setTimeout(OTA_TIMEOUT_MS / 1000 + 1);
+  size_t lineLength = client.readBytesUntil('\n', line, sizeof(line) - 1);
+  line[lineLength] = '\0';
+  bool ok = strncmp(line, "HTTP/1.", 7) == 0 && strncmp(line + 9, "200", 3) == 0;
+
+  size_t imageSize = 0;
+  while ((lineLength = client.readBytesUntil('\n', line, sizeof(line) - 1)) > 1) {
+    line[lineLength] = '\0';
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      imageSize = strtoul(line + 15, nullptr, 10);
+    }
+  }
+  return ok ? imageSize : 0;
+}
+
+// True if the image starting in the chunk is a build of something else than the running firmware
+bool isNewImage(size_t length) {
+  if (length < descriptionOffset + sizeof(esp_app_desc_t)) {
+    return false;
+  }
+  const esp_app_desc_t *image = reinterpret_cast<const esp_app_desc_t *>(chunk + descriptionOffset);
+  return image->magic_word == ESP_APP_DESC_MAGIC_WORD &&
+         memcmp(image->app_elf_sha256, runningDescription()->app_elf_sha256, sizeof(image->app_elf_sha256)) != 0;
+}
+
+// Stream the image into the inactive slot, true once it is verified and set to boot
+bool downloadImage() {
+  const esp_partition_t *target = esp_ota_get_next_update_partition(nullptr);
+  size_t imageSize = requestImage();
+  if (target == nullptr || imageSize == 0 || imageSize > target->size) {
+    return false;
+  }
+
+  size_t length = imageSize < OTA_CHUNK ? imageSize : OTA_CHUNK;
+  if (client.readBytes(chunk, length) != length || !isNewImage(length)) {
+    return false; // nothing written yet
+  }
+
+  esp_ota_handle_t handle;
+  if (esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &handle) != ESP_OK) {
+    return false;
+  }
+  size_t written = 0;
+  bytesWritten.store(0, std::memory_order_relaxed);
+  for (;;) {
+    if (esp_ota_write(handle, chunk, length) != ESP_OK) {
+      break;
+    }
+    written += length;
+    bytesWritten.store(written, std::memory_order_relaxed);
+    if (written == imageSize) {
+      // Checks the whole image, then points the boot loader at it
+      return esp_ota_end(handle) == ESP_OK && esp_ota_set_boot_partition(target) == ESP_OK;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(OTA_CHUNK_PAUSE_MS)); // the flash goes back to the sampling and the display
+    length = imageSize - written < OTA_CHUNK ? imageSize - written : OTA_CHUNK;
+    if (client.readBytes(chunk, length) != length) {
+      break; // connection lost or timed out
+    }
+  }
+  esp_ota_abort(handle);
+  return false;
+}
+
+void updateLoop(void *) {
+  vTaskDelay(pdMS_TO_TICKS(OTA_FIRST_CHECK_MS));
+  for (;;) {
+    if (wifiAcquire(OTA_TIMEOUT_MS)) {
+      bool ready = downloadImage();
+      client.stop();
+      wifiRelease();
+      if (ready) {
+        restartDue.store(true, std::memory_order_release);
+        vTaskDelete(nullptr); // nothing left to do until the restart
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(OTA_CHECK_MS));
+  }
+}
+}
+
+void otaBegin() {
+  xTaskCreatePinnedToCore(updateLoop, "ota", OTA_TASK_STACK, nullptr, 1, nullptr, 0);
+}
+
+bool otaRestartDue() {
+  return restartDue.load(std::memory_order_acquire);
+}
+
+void otaRestart() {
+  esp_restart();
+}
+
+void otaConfirmImage() {
+  esp_ota_img_states_t state;
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+      state == ESP_OTA_IMG_PENDING_VERIFY) {
+    esp_ota_mark_app_valid_cancel_rollback();
+  }
+}
+
+uint32_t otaBytesWritten() {
+  return bytesWritten.load(std::memory_order_relaxed);
+}
+
+#endif
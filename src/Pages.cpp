@@ -0,0 +1,255 @@
+/*********************************************************************************************************
+ * Pages
+ *
+ * How It Works:
+ *   1. Each page is a set of four functions: draw its background onto a canvas, invalidate its values
+ *       (the background was just put on the panel), tell whether it has something to draw, and draw it.
+ *   2. Showing a page pushes its background sprite. The sprite is created in PSRAM and rendered the
+ *       first time the page is shown; the live page's boot screen comes from the static frame cache
+ *       instead (StaticFrame.h), so its sprite is only rendered when the page is shown again.
+ *   3. nextPage() only records the switch; the background goes out on the next updatePage(), with the
+ *       page's values right after it.
+ *   4. The trend page rebuilds its plot from the history when shown, then adds the samples the history
+ *       gained since, so it never scrolls or draws while hidden. The min/max page combines the history's
+ *       window aggregates when shown and whenever a sample was added while it is on screen.
+**********************************************************************************************************/
+
+#include "Pages.h"
+#include "Diagnostics.h"
+#include "Display.h"
+#include "DisplayPush.h"
+#include "FixedFormat.h"
+#include "History.h"
+#include "Layout.h"
+#include "TrendGraph.h"
+
+namespace {
+const uint8_t pageCount = static_cast<uint8_t>(Page::COUNT);
+
+// One page
+struct PageHandlers {
+  void (*drawBackground)(TFT_eSPI &canvas); // static part, rendered once into the page's sprite
+  void (*invalidate)();                     // the background is on the panel, draw every value again
+  bool (*dirty)();                          // something to draw
+  void (*update)();                         // draw it
+};
+
+// Trend page
+TrendPlot trendPlot = TrendPlot(&tft);
+bool trendPlotCreated = false;
+bool trendPushDue = false;
+uint32_t trendShownEnd = 0;                 // history.endIndex() already in the plot
+
+void drawTrendBackground(TFT_eSPI &canvas) {
+  drawPageTitle(canvas, "Trend");
+  drawTrendLegend(canvas, 0, Layout::trendLegendY, PAGE_TREND_SPAN_MINUTES);
+
+  char range[32];
+  snprintf(range, sizeof(range), "T %d..%d C  RH %d..%d %%", GRAPH_T_MIN / 10, GRAPH_T_MAX / 10, GRAPH_RH_MIN / 10,
+           GRAPH_RH_MAX / 10);
+  canvas.setTextFont(Layout::smallFont);
+  canvas.drawString(range, 0, Layout::trendRangeY);
+  canvas.setTextFont(Layout::font);
+}
+
+void invalidateTrendPage() {
+  if (!trendPlotCreated) {
+    trendPlotCreated = trendPlot.begin(Layout::trendPlot.w, Layout::trendPlot.h, PAGE_TREND_SPAN_MINUTES, true);
+  }
+  trendPlot.replay(history);
+  trendShownEnd = history.endIndex();
+  trendPushDue = trendPlotCreated;
+}
+
+bool trendPageDirty() {
+  return trendPushDue || (trendPlotCreated && history.endIndex() != trendShownEnd);
+}
+
+void updateTrendPage() {
+  HistorySample sample;
+  for (; trendShownEnd < history.endIndex(); trendShownEnd++) {
+    if (history.get(trendShownEnd, sample)) {
+      trendPlot.add(sample.t_decidegC, sample.rh_decipct, sample.ts * 1000);
+    }
+  }
+  displayFence();
+  trendPlot.sprite().pushSprite(Layout::trendPlot.x, Layout::trendPlot.y); // PSRAM sprite, pushed directly
+  trendPushDue = false;
+}
+
+// Min/max page, one section per span
+const uint8_t statsSpans = 2;
+const char *const statsTitles[statsSpans] = { "Recent", "All" };
+const char *const statsLabels[Layout::statsLines] = { nullptr, "T min", "T max", "T mean", "RH min", "RH max", "RH mean" };
+
+PageValue statsValues[statsSpans][Layout::statsLines];
+bool statsDue = false;
+uint32_t statsShownEnd = 0;                 // history.endIndex() the values were computed at
+
+void drawStatsBackground(TFT_eSPI &canvas) {
+  drawPageTitle(canvas, "Min / Max");
+  canvas.setTextFont(Layout::font);
+  for (uint8_t span = 0; span < statsSpans; span++) {
+    const Rect area = Layout::statsSection(span);
+    canvas.setTextColor(TFT_CYAN, TFT_BLACK);
+    canvas.drawString(statsTitles[span], area.x, area.y);
+    canvas.setTextColor(TFT_WHITE, TFT_BLACK);
+    for (uint8_t line = 1; line < Layout::statsLines; line++) {
+      canvas.drawString(statsLabels[line], area.x, area.y + line * Layout::lineHeight);
+    }
+  }
+}
+
+void invalidateStatsPage() {
+  for (PageValue(&section)[Layout::statsLines] : statsValues) {
+    for (PageValue &value : section) {
+      value.invalidate();
+    }
+  }
+  statsDue = true;
+}
+
+bool statsPageDirty() {
+  return statsDue || history.endIndex() != statsShownEnd;
+}
+
+// Time covered by an aggregate, "12 min", "5 h" or "3 d"
+void formatSpan(char (&text)[16], uint32_t seconds) {
+  if (seconds < 120 * 60) {
+    snprintf(text, sizeof(text), "%lu min", (unsigned long)(seconds / 60));
+  } else if (seconds < 48 * 3600) {
+    snprintf(text, sizeof(text), "%lu h", (unsigned long)(seconds / 3600));
+  } else {
+    snprintf(text, sizeof(text), "%lu d", (unsigned long)(seconds / 86400));
+  }
+}
+
+void updateStatsPage() {
+  statsDue = false;
+  statsShownEnd = history.endIndex();
+  const HistoryAggregate aggregates[statsSpans] = { history.summarize(PAGE_STATS_RECENT_WINDOWS),
+                                                    history.summarize(UINT32_MAX) };
+
+  displayFence(); // direct drawing, let the queued pushes finish first
+  tft.setTextFont(Layout::font);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  for (uint8_t span = 0; span < statsSpans; span++) {
+    const HistoryAggregate &aggregate = aggregates[span];
+    const Rect area = Layout::statsSection(span);
+    const int16_t x = area.x + Layout::statsValueX;
+    const int16_t width = area.w - Layout::statsValueX;
+
+    char spanText[16];
+    DeciText lines[Layout::statsLines - 1];
+    if (aggregate.count > 0) {
+      formatSpan(spanText, aggregate.endTs - aggregate.startTs);
+      formatDeci(lines[0], aggregate.tMin, 'C');
+      formatDeci(lines[1], aggregate.tMax, 'C');
+      formatDeci(lines[2], aggregate.tMean(), 'C');
+      formatDeci(lines[3], static_cast<int16_t>(aggregate.rhMin), '%');
+      formatDeci(lines[4], static_cast<int16_t>(aggregate.rhMax), '%');
+      formatDeci(lines[5], static_cast<int16_t>(aggregate.rhMean()), '%');
+    } else {
+      strcpy(spanText, "--"); // no valid sample yet
+      for (DeciText &line : lines) {
+        strcpy(line, "--");
+      }
+    }
+
+    statsValues[span][0].draw(x, area.y, width, spanText);
+    for (uint8_t line = 1; line < Layout::statsLines; line++) {
+      statsValues[span][line].draw(x, area.y + line * Layout::lineHeight, width, lines[line - 1]);
+    }
+  }
+}
+
+const PageHandlers pages[pageCount] = {
+  { drawLiveBackground, invalidateLiveScreen, displayDirty, updateDynamicElements },
+  { drawTrendBackground, invalidateTrendPage, trendPageDirty, updateTrendPage },
+  { drawStatsBackground, invalidateStatsPage, statsPageDirty, updateStatsPage },
+#if DIAGNOSTICS
+  { drawDiagnosticsBackground, invalidateDiagnosticsPage, diagnosticsPageDirty, drawDiagnosticsPage },
+#endif
+};
+
+TFT_eSprite *backgrounds[pageCount] = {};   // created the first time their page is shown
+bool backgroundFailed[pageCount] = {};      // no PSRAM for it, drawn directly
+Page current = Page::LIVE;
+bool backgroundDue = false;                 // a switch is waiting for the next update
+
+// Render a page's background into a new full-screen PSRAM sprite, nullptr if there is no room
+TFT_eSprite *renderBackground(uint8_t index) {
+  TFT_eSprite *sprite = new TFT_eSprite(&tft);
+  sprite->setColorDepth(16);
+  sprite->setAttribute(PSRAM_ENABLE, true);
+  if (sprite->createSprite(Layout::width, Layout::height) == nullptr) {
+    delete sprite;
+    return nullptr;
+  }
+  sprite->fillSprite(TFT_BLACK);
+  pages[index].drawBackground(*sprite);
+  return sprite;
+}
+}
+
+void PageValue::draw(int16_t x, int16_t y, int16_t width, const char *text) {
+  if (_drawn && strncmp(_text, text, sizeof(_text) - 1) == 0) {
+    return; // already on the panel
+  }
+  tft.setTextPadding(width); // the padding clears the tail of a longer old text
+  tft.drawString(text, x, y);
+  tft.setTextPadding(0);
+  strncpy(_text, text, sizeof(_text) - 1);
+  _text[sizeof(_text) - 1] = '\0';
+  _drawn = true;
+}
+
+void nextPage() {
+  current = static_cast<Page>((static_cast<uint8_t>(current) + 1) % pageCount);
+  backgroundDue = true;
+}
+
+Page currentPage() {
+  return current;
+}
+
+void drawPageBackground() {
+  backgroundDue = false;
+  uint8_t index = static_cast<uint8_t>(current);
+  if (backgrounds[index] == nullptr && !backgroundFailed[index]) {
+    backgrounds[index] = renderBackground(index); // in RAM, nothing on the bus yet
+    backgroundFailed[index] = backgrounds[index] == nullptr;
+  }
+
+  displayFence(); // direct drawing, let the queued pushes finish first
+  if (backgrounds[index] != nullptr) {
+    backgrounds[index]->pushSprite(0, 0); // one window write for the whole page
+  } else if (current == Page::LIVE) {
+    drawStaticElements(); // blitted from the static frame cache
+    return;
+  } else {
+    tft.fillScreen(TFT_BLACK);
+    pages[index].drawBackground(tft);
+  }
+  tft.setTextFont(Layout::font);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  pages[index].invalidate();
+}
+
+bool pageDirty() {
+  return backgroundDue || pages[static_cast<uint8_t>(current)].dirty();
+}
+
+void updatePage() {
+  if (backgroundDue) {
+    drawPageBackground();
+  }
+  pages[static_cast<uint8_t>(current)].update();
+}
+
+void drawPageTitle(TFT_eSPI &canvas, const char *title) {
+  canvas.setTextFont(Layout::font);
+  canvas.setTextColor(TFT_CYAN, TFT_BLACK);
+  canvas.drawString(title, 0, 0);
+  canvas.setTextColor(TFT_WHITE, TFT_BLACK);
+}
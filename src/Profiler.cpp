@@ -0,0 +1,195 @@
+/*********************************************************************************************************
+ * Loop Profiler
+ *
+ * Histogram Buckets:
+ *   Values 0-3 us have a bucket each. Above that, a value with its highest set bit at position m falls
+ *    into one of 4 buckets for the range [2^m, 2^(m+1)), picked by the two bits below the highest one.
+ *    That gives 124 buckets for the full 32-bit range at 4 bytes each.
+**********************************************************************************************************/
+
+#include "Profiler.h"
+
+#if PROFILER
+
+#include <esp_timer.h>
+#include "Alarm.h"
+#include "Display.h"
+#include "DisplayPush.h"
+#include "FleetView.h"
+#include "Layout.h"
+#include "TrendGraph.h"
+
+namespace {
+const uint8_t sectionCount = static_cast<uint8_t>(ProfileSection::COUNT);
+const uint8_t bucketCount = 124;
+const char *sectionNames[sectionCount] = { "READ_SENSOR", "UPDATE_DISPLAY", "WAIT", "ALERT" };
+
+struct SectionHistogram {
+  uint32_t buckets[bucketCount];
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t sumUs;
+};
+
+SectionHistogram histograms[sectionCount];
+uint32_t loopCount = 0;
+uint32_t loopRate_centiHz = 0;  // loops per second x 100 in the last full window
+int64_t loopWindowStart = 0;
+int64_t lastReport = 0;
+bool overlayVisible = false;
+int64_t lastOverlayDraw = 0;
+
+uint8_t bucketOf(uint32_t us) {
+  if (us < 4) {
+    return us;
+  }
+  uint8_t msb = 31 - __builtin_clz(us);
+  uint8_t sub = (us >> (msb - 2)) & 3;
+  return (msb - 1) * 4 + sub;
+}
+
+// Largest value that falls into a bucket
+uint32_t bucketUpperBound(uint8_t bucket) {
+  if (bucket < 4) {
+    return bucket;
+  }
+  uint8_t msb = bucket / 4 + 1;
+  uint8_t sub = bucket % 4;
+  uint64_t lower = (uint64_t)(4 + sub) << (msb - 2);
+  return (uint32_t)(lower + (1ULL << (msb - 2)) - 1);
+}
+}
+
+void profilerRecord(ProfileSection section, uint32_t us) {
+  SectionHistogram &histogram = histograms[static_cast<uint8_t>(section)];
+  histogram.buckets[bucketOf(us)]++;
+  if (histogram.count == 0 || us < histogram.minUs) {
+    histogram.minUs = us;
+  }
+  if (us > histogram.maxUs) {
+    histogram.maxUs = us;
+  }
+  histogram.sumUs += us;
+  histogram.count++;
+}
+
+void profilerLoopTick() {
+  loopCount++;
+  int64_t now = esp_timer_get_time();
+  if (now - loopWindowStart >= (int64_t)PROFILER_RATE_WINDOW_MS * 1000) {
+    loopRate_centiHz = loopCount * 100000000LL / (now - loopWindowStart);
+    loopCount = 0;
+    loopWindowStart = now;
+  }
+}
+
+ProfileStats profilerStats(ProfileSection section) {
+  const SectionHistogram &histogram = histograms[static_cast<uint8_t>(section)];
+  ProfileStats stats = { histogram.count, histogram.minUs, histogram.maxUs, 0, 0 };
+  if (histogram.count == 0) {
+    return stats;
+  }
+  stats.meanUs = histogram.sumUs / histogram.count;
+
+  // Walk the buckets up to the 99th percentile
+  uint32_t target = histogram.count - histogram.count / 100;
+  uint32_t seen = 0;
+  for (uint8_t bucket = 0; bucket < bucketCount; bucket++) {
+    seen += histogram.buckets[bucket];
+    if (seen >= target) {
+      uint32_t bound = bucketUpperBound(bucket);
+      stats.p99Us = bound < histogram.maxUs ? bound : histogram.maxUs;
+      break;
+    }
+  }
+  return stats;
+}
+
+uint32_t profilerLoopRate_centiHz() {
+  return loopRate_centiHz;
+}
+
+void profilerReport(Print &out) {
+  out.printf("# profile loops/s=%lu.%02lu\n", (unsigned long)(loopRate_centiHz / 100),
+             (unsigned long)(loopRate_centiHz % 100));
+  for (uint8_t i = 0; i < sectionCount; i++) {
+    ProfileStats stats = profilerStats(static_cast<ProfileSection>(i));
+    out.printf("profile,%s,count=%lu,min=%lu,max=%lu,mean=%lu,p99=%lu\n", sectionNames[i],
+               (unsigned long)stats.count, (unsigned long)stats.minUs, (unsigned long)stats.maxUs,
+               (unsigned long)stats.meanUs, (unsigned long)stats.p99Us);
+  }
+#if ALARMS
+  AlarmStats alarms = alarmStats();
+  out.printf("alarm,raised=%lu,pin_max=%lu,screen_max=%lu,over_budget=%lu,dropped=%lu\n",
+             (unsigned long)alarms.raised, (unsigned long)alarms.maxPinLatencyUs,
+             (unsigned long)alarms.maxScreenLatencyUs, (unsigned long)alarms.overBudget,
+             (unsigned long)alarms.dropped);
+#endif
+}
+
+bool profilerReportDue() {
+  if (PROFILER_REPORT_MS == 0) {
+    return false;
+  }
+  int64_t now = esp_timer_get_time();
+  if (now - lastReport < (int64_t)PROFILER_REPORT_MS * 1000) {
+    return false;
+  }
+  lastReport = now;
+  return true;
+}
+
+void profilerToggleOverlay() {
+  overlayVisible = !overlayVisible;
+  lastOverlayDraw = 0; // draw at once when shown
+  if (!overlayVisible) {
+    // Give the area back to the trend graph
+    displayFence();
+    tft.fillRect(Layout::overlay.x, Layout::overlay.y, Layout::overlay.w, Layout::overlay.h, TFT_BLACK);
+    drawTrendGraphFrame();
+#if MESH_ROLE == MESH_AGGREGATOR
+    invalidateFleetView();
+#endif
+  }
+}
+
+void invalidateProfilerOverlay() {
+  lastOverlayDraw = 0;
+}
+
+bool profilerOverlayVisible() {
+  return overlayVisible;
+}
+
+bool profilerOverlayDirty() {
+  return overlayVisible && esp_timer_get_time() - lastOverlayDraw >= (int64_t)PROFILER_OVERLAY_MS * 1000;
+}
+
+void drawProfilerOverlay() {
+  lastOverlayDraw = esp_timer_get_time();
+  displayFence();
+  tft.fillRect(Layout::overlay.x, Layout::overlay.y, Layout::overlay.w, Layout::overlay.h, TFT_BLACK);
+  tft.setTextFont(Layout::smallFont);
+  tft.setTextColor(TFT_YELLOW, TFT_BLACK);
+  // One cursor per line, a newline would return to x = 0 instead of the overlay's left edge
+  int16_t y = Layout::overlay.y;
+  const int16_t lineHeight = 8;
+  tft.setCursor(Layout::overlay.x, y);
+  tft.printf("loops/s %lu.%02lu", (unsigned long)(loopRate_centiHz / 100), (unsigned long)(loopRate_centiHz % 100));
+
+  const char *shortNames[sectionCount] = { "READ", "DISP", "WAIT", "ALRT" };
+  for (uint8_t i = 0; i < sectionCount; i++) {
+    ProfileStats stats = profilerStats(static_cast<ProfileSection>(i));
+    tft.setCursor(Layout::overlay.x, y += lineHeight);
+    tft.printf("%s n=%lu mean %lu us", shortNames[i], (unsigned long)stats.count, (unsigned long)stats.meanUs);
+    tft.setCursor(Layout::overlay.x, y += lineHeight);
+    tft.printf(" min %lu max %lu", (unsigned long)stats.minUs, (unsigned long)stats.maxUs);
+    tft.setCursor(Layout::overlay.x, y += lineHeight);
+    tft.printf(" p99 %lu us", (unsigned long)stats.p99Us);
+  }
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.setTextFont(Layout::font);
+}
+
+#endif // PROFILER
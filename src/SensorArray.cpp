@@ -0,0 +1,15 @@
+/*********************************************************************************************************
+ * Sensor Array
+**********************************************************************************************************/
+
+#include "SensorArray.h"
+
+namespace {
+// One DhtSensor per configured pin, constructed in place (DhtSensor is not meant to be copied)
+template <size_t... I>
+SensorArray makeSensors(std::index_sequence<I...>) {
+  return SensorArray{ { DhtSensor(sensorPins[I], dhtProfile(sensorTypes[I]))... } };
+}
+}
+
+SensorArray sensors = makeSensors(std::make_index_sequence<sensorCount>());
@@ -0,0 +1,209 @@
+/*********************************************************************************************************
+ * Sensor Acquisition Task
+ *
+ * How It Works:
+ *   1. Every SENSOR_READ_INTERVAL_MS is split into one slot per sensor of the array, and each slot reads
+ *       the next sensor round-robin. Start pulses are staggered by a slot, so reads never overlap on
+ *       the shared RMT channel and every sensor is read once per interval: throughput grows linearly
+ *       with the number of sensors.
+ *   2. The task starts a read, then yields one tick at a time while the driver captures the frame.
+ *   3. The result is tagged with the sensor index, checked against the alarm limits (Alarm.h) and
+ *       pushed into the SPSC queue and the consumer task is notified; if the consumer has fallen
+ *       behind the sample is dropped and counted instead of blocking the producer.
+ *   4. vTaskDelayUntil() sleeps until the next slot, measured from the previous wake time,
+ *       so the cadence does not drift with the read duration.
+ *   5. Failed reads back off exponentially per sensor (every 2nd, 4th, ... round up to
+ *       SENSOR_BACKOFF_MAX_MS), so a missing sensor costs fewer reads than a healthy one.
+ *   6. With ADAPTIVE_SAMPLING, a sensor whose readings stay within ADAPTIVE_STABLE_T/RH of the previous
+ *       read (one LSB by default) is read every 2nd, 4th, ... round up to ADAPTIVE_INTERVAL_MAX_MS. A
+ *       change faster than ADAPTIVE_RATE_T/RH per minute returns it to every round at once; anything in
+ *       between keeps the current interval. The rate is measured against a reference reading that is
+ *       renewed every ADAPTIVE_RATE_WINDOW_MS, over at least that window, so the single-LSB steps of
+ *       two consecutive reads never count as a fast change while a large step still does at once.
+ *   7. Rounds in which no sensor is due are slept through in one vTaskDelayUntil(), so a stable site
+ *       costs one wake-up per read and not one per slot.
+ *   8. In SCHEDULER_LIGHT_SLEEP mode a power management lock keeps the chip out of light sleep while a
+ *       frame is being captured, and lets it sleep for the rest of the interval.
+**********************************************************************************************************/
+
+#include "SensorTask.h"
+#include <esp_timer.h>
+#include "Alarm.h"
+#include "SpscQueue.h"
+
+#if SCHEDULER_MODE == SCHEDULER_LIGHT_SLEEP && CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#define SENSOR_PM_LOCK 1
+#else
+#define SENSOR_PM_LOCK 0
+#endif
+
+namespace {
+SpscQueue<SensorSample, SENSOR_QUEUE_LENGTH> sampleQueue; // sensor task -> loop()
+std::atomic<uint32_t> droppedSamples{0};
+TaskHandle_t consumerTask = nullptr;                      // notified when a sample lands
+#if SENSOR_PM_LOCK
+esp_pm_lock_handle_t noSleepLock = nullptr;               // held while a frame is captured
+#endif
+
+// Round-robin state of one sensor
+struct SensorSlot {
+  uint8_t backoffShift;    // failed reads back off to SENSOR_READ_INTERVAL_MS << backoffShift
+  uint16_t roundsToSkip;   // rounds left before the sensor is read again
+  uint16_t adaptiveRounds; // rounds between reads while the readings are stable (adaptive sampling)
+  bool haveLast;           // last* hold the previous valid reading
+  int16_t lastTemperature;
+  uint16_t lastHumidity;
+  int16_t referenceTemperature; // reading the rates are measured against, renewed every rate window
+  uint16_t referenceHumidity;
+  uint32_t referenceTs;
+};
+
+// Longest adaptive interval in rounds
+constexpr uint16_t maxAdaptiveRounds = ADAPTIVE_INTERVAL_MAX_MS / SENSOR_READ_INTERVAL_MS > 0
+                                         ? ADAPTIVE_INTERVAL_MAX_MS / SENSOR_READ_INTERVAL_MS : 1;
+
+// Change per minute of a value that moved by delta within elapsedMs
+uint32_t ratePerMinute(int32_t delta, uint32_t elapsedMs) {
+  uint32_t magnitude = delta < 0 ? -delta : delta;
+  return elapsedMs == 0 ? UINT32_MAX : (uint64_t)magnitude * 60000 / elapsedMs;
+}
+
+// Adapt a sensor's read interval to how fast its readings move
+void adaptInterval(SensorSlot &slot, const SensorSample &sample) {
+  uint32_t elapsed = sample.ts - slot.referenceTs;
+  if (!slot.haveLast) {
+    slot.adaptiveRounds = 1;
+  } else {
+    // Over the full window even before it has passed: a lower bound of the rate, so one LSB is slow
+    uint32_t span = elapsed > ADAPTIVE_RATE_WINDOW_MS ? elapsed : ADAPTIVE_RATE_WINDOW_MS;
+    int32_t temperatureDelta = sample.t_decidegC - slot.lastTemperature;
+    int32_t humidityDelta = (int32_t)sample.rh_decipct - slot.lastHumidity;
+
+    if (ratePerMinute(sample.t_decidegC - slot.referenceTemperature, span) > ADAPTIVE_RATE_T ||
+        ratePerMinute((int32_t)sample.rh_decipct - slot.referenceHumidity, span) > ADAPTIVE_RATE_RH) {
+      slot.adaptiveRounds = 1; // moving, back to full rate
+    } else if (abs(temperatureDelta) <= ADAPTIVE_STABLE_T && abs(humidityDelta) <= ADAPTIVE_STABLE_RH) {
+      uint16_t doubled = slot.adaptiveRounds * 2;
+      slot.adaptiveRounds = doubled < maxAdaptiveRounds ? doubled : maxAdaptiveRounds;
+    }
+  }
+
+  if (!slot.haveLast || elapsed >= ADAPTIVE_RATE_WINDOW_MS) {
+    slot.referenceTemperature = sample.t_decidegC;
+    slot.referenceHumidity = sample.rh_decipct;
+    slot.referenceTs = sample.ts;
+  }
+  slot.haveLast = true;
+  slot.lastTemperature = sample.t_decidegC;
+  slot.lastHumidity = sample.rh_decipct;
+}
+
+// Largest shift that keeps the backoff interval within SENSOR_BACKOFF_MAX_MS
+constexpr uint8_t maxBackoffShift(uint32_t interval = SENSOR_READ_INTERVAL_MS, uint8_t shift = 0) {
+  return interval * 2 > SENSOR_BACKOFF_MAX_MS ? shift : maxBackoffShift(interval * 2, shift + 1);
+}
+
+// One slot per sensor and round, rounded up so a sensor is never read faster than the interval
+constexpr uint32_t slotMs = (SENSOR_READ_INTERVAL_MS + sensorCount - 1) / sensorCount;
+static_assert(slotMs >= 50, "too many sensors for SENSOR_READ_INTERVAL_MS, a read needs up to ~30 ms");
+
+void sensorTask(void *) {
+  SensorSlot slots[sensorCount] = {};
+  TickType_t lastWake = xTaskGetTickCount();
+  uint8_t next = 0;
+
+  for (;;) {
+    SensorSlot &slot = slots[next];
+    uint8_t index = next;
+    next = (next + 1) % sensorCount;
+
+    // Start the read and wait for the frame without hogging the core
+#if SENSOR_PM_LOCK
+    esp_pm_lock_acquire(noSleepLock);
+#endif
+    SensorSample sample = readSensor(sensors[index]);
+#if SENSOR_PM_LOCK
+    esp_pm_lock_release(noSleepLock);
+#endif
+    sample.sensor = index;
+
+#if ALARMS
+    // Alarms first, the output pin must not wait behind the queue
+    evaluateAlarms(sample, esp_timer_get_time());
+#endif
+
+    // Publish the result
+    if (sampleQueue.push(sample)) {
+      xTaskNotifyGive(consumerTask);
+    } else {
+      droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Back off while the sensor is not answering, slow down while it is stable
+    uint16_t rounds = 1;
+    if (sample.valid()) {
+      slot.backoffShift = 0;
+#if ADAPTIVE_SAMPLING
+      adaptInterval(slot, sample);
+      rounds = slot.adaptiveRounds;
+#endif
+    } else {
+      if (slot.backoffShift < maxBackoffShift()) {
+        slot.backoffShift++;
+      }
+      slot.haveLast = false; // the first good read after an outage starts at full rate
+      rounds = 1 << slot.backoffShift;
+    }
+    slot.roundsToSkip = rounds - 1;
+
+    // Sleep until the slot of the next sensor that is due, skipping the slots of the others
+    uint32_t slotsToSleep = 1;
+    while (slots[next].roundsToSkip > 0) {
+      slots[next].roundsToSkip--;
+      next = (next + 1) % sensorCount;
+      slotsToSleep++;
+    }
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(slotMs * slotsToSleep));
+  }
+}
+}
+
+SensorSample readSensor(DhtSensor &sensor) {
+  sensor.startRead();
+  while (sensor.poll() == DhtSensor::Status::BUSY) {
+    vTaskDelay(1);
+  }
+  return sensor.sample();
+}
+
+void startSensorTask() {
+  for (DhtSensor &sensor : sensors) {
+    sensor.begin();
+  }
+
+  consumerTask = xTaskGetCurrentTaskHandle();
+#if SENSOR_PM_LOCK
+  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "sensor", &noSleepLock);
+#endif
+  xTaskCreatePinnedToCore(sensorTask, "sensor", SENSOR_TASK_STACK, nullptr, SENSOR_TASK_PRIORITY,
+                          nullptr, SENSOR_TASK_CORE);
+}
+
+bool receiveSensorSample(SensorSample &sample) {
+  return sampleQueue.pop(sample);
+}
+
+bool waitForSensorSample(SensorSample &sample, TickType_t timeout) {
+  if (sampleQueue.pop(sample)) {
+    return true;
+  }
+
+  // A notification given after the failed pop is kept, so a sample cannot be missed here
+  ulTaskNotifyTake(pdTRUE, timeout);
+  return sampleQueue.pop(sample);
+}
+
+uint32_t droppedSensorSamples() {
+  return droppedSamples.load(std::memory_order_relaxed);
+}
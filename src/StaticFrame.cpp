@@ -0,0 +1,105 @@
+/*********************************************************************************************************
+ * Static Frame Cache
+ *
+ * Image Format (NVS blob "frame"/"image"):
+ *   struct { uint32_t key; int16_t width; int16_t height; } header, then height rows of (width + 7) / 8
+ *    bytes, most significant bit first, 1 = text (white), 0 = background (black).
+ *
+ * Blitting:
+ *   Rows are expanded into a 16-bit band buffer of blitBandRows lines and sent with pushImage(), one
+ *    address window per band. Both buffers only live for the duration of the call.
+**********************************************************************************************************/
+
+#include "StaticFrame.h"
+#include <Preferences.h>
+#include <stdlib.h>
+#include "Display.h"
+
+namespace {
+const char *cacheNamespace = "frame";
+const char *cacheKey = "image";
+const uint8_t blitBandRows = 8;
+
+struct FrameHeader {
+  uint32_t key;
+  int16_t width;
+  int16_t height;
+};
+
+size_t imageSize(int16_t width, int16_t height) {
+  return sizeof(FrameHeader) + ((width + 7) / 8) * height;
+}
+}
+
+bool blitStaticFrame(uint32_t key, int16_t width, int16_t height) {
+  Preferences cache;
+  if (!cache.begin(cacheNamespace, true)) {
+    return false; // namespace does not exist yet
+  }
+  size_t size = imageSize(width, height);
+  uint8_t *image = static_cast<uint8_t *>(malloc(size));
+  uint16_t *band = static_cast<uint16_t *>(malloc(width * blitBandRows * sizeof(uint16_t)));
+  bool loaded = image != nullptr && band != nullptr && cache.getBytesLength(cacheKey) == size &&
+                cache.getBytes(cacheKey, image, size) == size;
+  cache.end();
+
+  FrameHeader header = {};
+  if (loaded) {
+    memcpy(&header, image, sizeof(header));
+  }
+  if (!loaded || header.key != key || header.width != width || header.height != height) {
+    free(image);
+    free(band);
+    return false; // missing, or made for a different layout
+  }
+
+  const uint8_t *rows = image + sizeof(FrameHeader);
+  const size_t stride = (width + 7) / 8;
+  tft.setSwapBytes(true); // band holds native RGB565 values
+  for (int16_t y = 0; y < height; y += blitBandRows) {
+    int16_t bandRows = height - y < blitBandRows ? height - y : blitBandRows;
+    for (int16_t row = 0; row < bandRows; row++) {
+      const uint8_t *bits = rows + (y + row) * stride;
+      uint16_t *pixels = band + row * width;
+      for (int16_t x = 0; x < width; x++) {
+        pixels[x] = (bits[x >> 3] & (0x80 >> (x & 7))) ? TFT_WHITE : TFT_BLACK;
+      }
+    }
+    tft.pushImage(0, y, width, bandRows, band);
+  }
+  tft.setSwapBytes(false);
+
+  free(image);
+  free(band);
+  return true;
+}
+
+void storeStaticFrame(uint32_t key, TFT_eSprite &frame) {
+  int16_t width = frame.width();
+  int16_t height = frame.height();
+  uint8_t *image = static_cast<uint8_t *>(malloc(imageSize(width, height)));
+  if (image == nullptr) {
+    return;
+  }
+
+  // Pack through readPixel(), independent of how the sprite lays out its bits
+  FrameHeader header = { key, width, height };
+  memcpy(image, &header, sizeof(header));
+  uint8_t *rows = image + sizeof(FrameHeader);
+  const size_t stride = (width + 7) / 8;
+  memset(rows, 0, stride * height);
+  for (int16_t y = 0; y < height; y++) {
+    for (int16_t x = 0; x < width; x++) {
+      if (frame.readPixel(x, y) != TFT_BLACK) {
+        rows[y * stride + (x >> 3)] |= 0x80 >> (x & 7);
+      }
+    }
+  }
+
+  Preferences cache;
+  if (cache.begin(cacheNamespace, false)) {
+    cache.putBytes(cacheKey, image, imageSize(width, height));
+    cache.end();
+  }
+  free(image);
+}
@@ -0,0 +1,217 @@
+/*********************************************************************************************************
+ * Telemetry Uplink
+ *
+ * How It Works:
+ *   1. Two batch buffers: loop() fills one, the uplink task sends the other. A trigger swaps them and
+ *       notifies the task; while a batch is still in flight the new one simply keeps filling, and the
+ *       triggers are checked again on every later call, a sample or not.
+ *   2. The task acquires the Wi-Fi link, writes the batch as JSON into the preallocated payload buffer
+ *       (snprintf only, no String) and POSTs it over a keep-alive connection.
+ *   3. After a batch the task lingers for TELEMETRY_LINGER_MS: a batch arriving in that time reuses the
+ *       connection, otherwise the connection is closed and the Wi-Fi link released (radio off).
+ *   4. A failed upload is retried TELEMETRY_RETRIES times before the batch is dropped and counted.
+**********************************************************************************************************/
+
+#include "Telemetry.h"
+
+#if TELEMETRY
+
+#include <atomic>
+#include <WiFi.h>
+#include "WifiLink.h"
+
+namespace {
+struct Batch {
+  uint32_t seconds[TELEMETRY_BATCH];
+  int16_t temperature[TELEMETRY_BATCH];
+  uint16_t humidity[TELEMETRY_BATCH];
+  DerivedSample derived[TELEMETRY_BATCH];
+  uint16_t count;
+  uint32_t openedAt;            // millis() of the first sample
+};
+
+Batch batches[2];
+uint8_t filling = 0;            // batch loop() is filling
+std::atomic<bool> inFlight{false};
+std::atomic<uint32_t> droppedSamples{0};
+TaskHandle_t uplinkTask = nullptr;
+int16_t lastSentTemperature = 0; // values of the last sample handed to the uplink
+uint16_t lastSentHumidity = 0;
+bool haveSent = false;
+
+char payload[TELEMETRY_PAYLOAD_SIZE]; // preallocated request body
+WiFiClient client;                    // kept open between batches of one radio wake
+
+// Write a batch as JSON into the payload buffer, returns the length (0 if it did not fit)
+size_t formatBatch(const Batch &batch) {
+  int length = snprintf(payload, sizeof(payload), "{\"device\":\"%s\",\"samples\":[", DEVICE_NAME);
+  for (uint16_t i = 0; i < batch.count && length > 0 && length < (int)sizeof(payload); i++) {
+    const DerivedSample &derived = batch.derived[i];
+    length += snprintf(payload + length, sizeof(payload) - length, "%s[%lu,%d,%u,%d,%d,%u]", i ? "," : "",
+                       (unsigned long)batch.seconds[i], batch.temperature[i], batch.humidity[i],
+                       derived.dewPoint_decidegC, derived.heatIndex_decidegC, derived.absHumidity_decigm3);
+  }
+  if (length > 0 && length < (int)sizeof(payload)) {
+    length += snprintf(payload + length, sizeof(payload) - length, "]}");
+  }
+  return length > 0 && length < (int)sizeof(payload) ? length : 0;
+}
+
+// POST the payload over the kept-alive connection, true on a 2xx answer
+bool postPayload(size_t length) {
+  if (!client.connected() && !client.connect(TELEMETRY_HOST, TELEMETRY_PORT)) {
+    return false;
+  }
+
+  char header[192];
+  int headerLength = snprintf(header, sizeof(header),
+                              "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\n"
+                              "Content-Length: %u\r\nConnection: keep-alive\r\n\r\n",
+                              TELEMETRY_PATH, TELEMETRY_HOST, (unsigned)length);
+  client.write(reinterpret_cast<const uint8_t *>(header), headerLength);
+  client.write(reinterpret_cast<const uint8_t *>(payload), length);
+
+  // Status line, then skip the headers and the body so the connection can be reused
+  char line[96];
+  client.setTimeout(TELEMETRY_TIMEOUT_MS / 1000 + 1);
+  size_t lineLength = client.readBytesUntil('\n', line, sizeof(line) - 1);
+  line[lineLength] = '\0';
+  bool ok = strncmp(line, "HTTP/1.", 7) == 0 && line[9] == '2';
+
+  size_t bodyLength = 0;
+  while ((lineLength = client.readBytesUntil('\n', line, sizeof(line) - 1)) > 1) {
+    line[lineLength] = '\0';
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      bodyLength = strtoul(line + 15, nullptr, 10);
+    }
+  }
+  while (bodyLength > 0 && client.connected()) {
+    size_t skipped = client.readBytes(line, bodyLength < sizeof(line) ? bodyLength : sizeof(line));
+    if (skipped == 0) {
+      break;
+    }
+    bodyLength -= skipped;
+  }
+
+  if (!ok) {
+    client.stop(); // start from a fresh connection next time
+  }
+  return ok;
+}
+
+// Send one batch, retrying on failure
+bool sendBatch(const Batch &batch) {
+  size_t length = formatBatch(batch);
+  if (length == 0) {
+    return false;
+  }
+  for (uint8_t attempt = 0; attempt <= TELEMETRY_RETRIES; attempt++) {
+    if (postPayload(length)) {
+      return true;
+    }
+    vTaskDelay(pdMS_TO_TICKS(500 << attempt));
+  }
+  return false;
+}
+
+void uplinkLoop(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    if (!wifiAcquire(TELEMETRY_TIMEOUT_MS)) {
+      droppedSamples.fetch_add(batches[filling ^ 1].count, std::memory_order_relaxed);
+      inFlight.store(false, std::memory_order_release);
+      continue;
+    }
+
+    // Send, then linger so a following batch reuses the connection and the radio wake
+    do {
+      Batch &batch = batches[filling ^ 1];
+      if (!sendBatch(batch)) {
+        droppedSamples.fetch_add(batch.count, std::memory_order_relaxed);
+      }
+      inFlight.store(false, std::memory_order_release);
+    } while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TELEMETRY_LINGER_MS)) > 0);
+
+    client.stop();
+    wifiRelease();
+  }
+}
+
+// Hand the batch being filled over to the uplink task, false if the previous one is still going out
+bool handOver() {
+  if (inFlight.load(std::memory_order_acquire)) {
+    return false; // keep coalescing into the current batch
+  }
+  inFlight.store(true, std::memory_order_release);
+  filling ^= 1;
+  batches[filling].count = 0;
+  xTaskNotifyGive(uplinkTask);
+  return true;
+}
+}
+
+void telemetryBegin() {
+  xTaskCreatePinnedToCore(uplinkLoop, "uplink", TELEMETRY_TASK_STACK, nullptr, 1, &uplinkTask, 0);
+}
+
+void telemetryAdd(uint32_t seconds, const SensorSample &sample, const DerivedSample &derived) {
+  Batch &batch = batches[filling];
+  bool crossed = false;
+  if (sample.valid() && batch.count == TELEMETRY_BATCH) {
+    droppedSamples.fetch_add(1, std::memory_order_relaxed); // uplink busy and batch full
+  } else if (sample.valid()) {
+    if (batch.count == 0) {
+      batch.openedAt = millis();
+    }
+    batch.seconds[batch.count] = seconds;
+    batch.temperature[batch.count] = sample.t_decidegC;
+    batch.humidity[batch.count] = sample.rh_decipct;
+    batch.derived[batch.count] = derived;
+    batch.count++;
+    crossed = !haveSent ||
+              abs(sample.t_decidegC - lastSentTemperature) >= TELEMETRY_T_THRESHOLD ||
+              abs((int32_t)sample.rh_decipct - lastSentHumidity) >= TELEMETRY_RH_THRESHOLD;
+  }
+
+  // Flush triggers, checked on every call: a batch left behind by an invalid sample or a refused
+  // hand-over still goes out once it is full or late
+  if (batch.count == 0 || uplinkTask == nullptr) {
+    return;
+  }
+  bool full = batch.count == TELEMETRY_BATCH;
+  bool late = millis() - batch.openedAt >= TELEMETRY_MAX_LATENCY_MS;
+  int16_t temperature = batch.temperature[batch.count - 1];
+  uint16_t humidity = batch.humidity[batch.count - 1];
+
+  if ((crossed || full || late) && handOver()) {
+    lastSentTemperature = temperature;
+    lastSentHumidity = humidity;
+    haveSent = true;
+  }
+}
+
+bool telemetrySendNow() {
+  Batch &batch = batches[filling];
+  if (batch.count == 0) {
+    return true;
+  }
+
+  bool sent = false;
+  if (wifiAcquire(TELEMETRY_TIMEOUT_MS)) {
+    sent = sendBatch(batch);
+    client.stop();
+    wifiRelease();
+  }
+  if (!sent) {
+    droppedSamples.fetch_add(batch.count, std::memory_order_relaxed);
+  }
+  batch.count = 0;
+  return sent;
+}
+
+uint32_t telemetryDroppedSamples() {
+  return droppedSamples.load(std::memory_order_relaxed);
+}
+
+#endif
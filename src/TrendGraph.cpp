@@ -0,0 +1,222 @@
+/*********************************************************************************************************
+ * Trend Graph
+ *
+ * How It Works:
+ *   1. Every valid sample is mapped to a time slot (column) from its timestamp.
+ *   2. If the slot is newer than the last one drawn, the sprite scrolls left by the number of slots
+ *       that passed (gaps while the sensor was disconnected stay blank).
+ *   3. The sample is added to the slot's running mean, and only the newest column is cleared and
+ *       redrawn: grid dots plus one vertical segment per channel from the previous column's value.
+ *   4. updateTrendGraph() pushes the sprite as one block after a scroll or a cleared screen: nothing is
+ *       re-rendered, only the panel copy of the scrolled pixels is refreshed. A sample that stayed in the
+ *       newest slot only pushes that one column.
+ *   5. replay() builds a plot from the history instead: each column is drawn once at its final
+ *       position, so a rebuild never scrolls, and the newest slot keeps its running sums for add().
+**********************************************************************************************************/
+
+#include "TrendGraph.h"
+#include "Config.h"
+#include "Display.h"
+#include "DisplayPush.h"
+#include "History.h"
+#include "Layout.h"
+
+namespace {
+const int16_t gridStep = 25;               // rows between grid dots
+const uint16_t temperatureColour = TFT_RED;
+const uint16_t humidityColour = TFT_CYAN;
+const uint16_t gridColour = TFT_DARKGREY;
+
+TrendPlot graph = TrendPlot(&tft);         // the graph below the values
+bool dirty = false;
+bool fullPushDue = false;                  // scrolled or the screen was cleared since the last push
+}
+
+bool TrendPlot::begin(int16_t width, int16_t height, uint32_t spanMinutes, bool psram) {
+  _width = width;
+  _height = height;
+  _slotMs = spanMinutes * 60000UL / width;
+
+  _sprite.setColorDepth(16);
+  _sprite.setAttribute(PSRAM_ENABLE, psram);
+  if (_sprite.createSprite(width, height) == nullptr) {
+    _slotMs = 0; // samples are ignored
+    return false;
+  }
+  clear();
+  return true;
+}
+
+void TrendPlot::clear() {
+  _sprite.fillSprite(TFT_BLACK);
+  _haveSlot = false;
+  _newestTemperatureY = -1;
+  _newestHumidityY = -1;
+}
+
+// Map a value onto a plot row (0 = top), clamped to the plot area
+int16_t TrendPlot::valueToRow(int32_t value, int32_t minimum, int32_t maximum) const {
+  if (value < minimum) {
+    value = minimum;
+  } else if (value > maximum) {
+    value = maximum;
+  }
+  return (_height - 1) - (value - minimum) * (_height - 1) / (maximum - minimum);
+}
+
+// Vertical segment in a column joining the previous column's row to the new one
+void TrendPlot::drawSegment(int16_t x, int16_t previousRow, int16_t row, uint16_t colour) {
+  if (previousRow < 0) {
+    previousRow = row; // first column after a gap, just a dot
+  }
+  int16_t top = previousRow < row ? previousRow : row;
+  int16_t bottom = previousRow < row ? row : previousRow;
+  _sprite.drawFastVLine(x, top, bottom - top + 1, colour);
+}
+
+void TrendPlot::drawColumn(int16_t x) {
+  _sprite.drawFastVLine(x, 0, _height, TFT_BLACK);
+  for (int16_t y = 0; y < _height; y += gridStep) {
+    _sprite.drawPixel(x, y, gridColour);
+  }
+  if (_slotCount == 0) {
+    return; // blank slot
+  }
+
+  _newestTemperatureY = valueToRow(_temperatureSum / _slotCount, GRAPH_T_MIN, GRAPH_T_MAX);
+  _newestHumidityY = valueToRow(_humiditySum / _slotCount, GRAPH_RH_MIN, GRAPH_RH_MAX);
+  drawSegment(x, _previousHumidityY, _newestHumidityY, humidityColour);
+  drawSegment(x, _previousTemperatureY, _newestTemperatureY, temperatureColour);
+}
+
+void TrendPlot::startSlot(uint32_t slot, uint32_t elapsed) {
+  // The previous column only joins up if it is directly next to the new one
+  _previousTemperatureY = elapsed == 1 ? _newestTemperatureY : -1;
+  _previousHumidityY = elapsed == 1 ? _newestHumidityY : -1;
+  _newestTemperatureY = -1;
+  _newestHumidityY = -1;
+
+  _currentSlot = slot;
+  _haveSlot = true;
+  _temperatureSum = 0;
+  _humiditySum = 0;
+  _slotCount = 0;
+}
+
+bool TrendPlot::add(int16_t t_decidegC, uint16_t rh_decipct, uint32_t tsMs) {
+  if (_slotMs == 0) {
+    return false;
+  }
+
+  uint32_t slot = tsMs / _slotMs;
+  bool moved = !_haveSlot || slot != _currentSlot;
+  if (moved) {
+    // Scroll by the slots that passed, older columns are left as they are
+    uint32_t elapsed = _haveSlot ? slot - _currentSlot : 1;
+    if (elapsed >= (uint32_t)_width) {
+      _sprite.fillSprite(TFT_BLACK);
+      elapsed = 1;
+    } else {
+      _sprite.scroll(-(int16_t)elapsed, 0);
+    }
+    startSlot(slot, elapsed);
+  }
+
+  _temperatureSum += t_decidegC;
+  _humiditySum += rh_decipct;
+  _slotCount++;
+  drawColumn(_width - 1);
+  return moved;
+}
+
+void TrendPlot::replay(const History &history) {
+  clear();
+  uint32_t end = history.endIndex();
+  HistorySample sample;
+  if (_slotMs == 0 || end == 0 || !history.get(end - 1, sample)) {
+    return;
+  }
+
+  // First stored sample that still falls onto the plot (timestamps only grow, binary search). An empty
+  // slot follows a gap of over 18 hours, longer than any plot span, so it counts as too old.
+  const uint32_t newestSlot = sample.ts * 1000 / _slotMs;
+  uint32_t first = history.firstIndex();
+  uint32_t last = end - 1;
+  while (first < last) {
+    uint32_t middle = first + (last - first) / 2;
+    if (history.get(middle, sample) && newestSlot - sample.ts * 1000 / _slotMs < (uint32_t)_width) {
+      last = middle;
+    } else {
+      first = middle + 1;
+    }
+  }
+
+  for (uint32_t index = first; index < end; index++) {
+    if (!history.get(index, sample)) {
+      continue;
+    }
+    uint32_t slot = sample.ts * 1000 / _slotMs;
+    if (!_haveSlot || slot != _currentSlot) {
+      if (_haveSlot) {
+        drawColumn(_width - 1 - (newestSlot - _currentSlot)); // the finished column, at its final place
+      }
+      startSlot(slot, _haveSlot ? slot - _currentSlot : 1);
+    }
+    _temperatureSum += sample.t_decidegC;
+    _humiditySum += sample.rh_decipct;
+    _slotCount++;
+  }
+  drawColumn(_width - 1);
+}
+
+void drawTrendLegend(TFT_eSPI &canvas, int16_t x, int16_t y, uint16_t spanMinutes) {
+  canvas.setTextFont(Layout::smallFont);
+  canvas.setCursor(x, y);
+  canvas.setTextColor(temperatureColour, TFT_BLACK);
+  canvas.print("TEMP ");
+  canvas.setTextColor(humidityColour, TFT_BLACK);
+  canvas.print("RH");
+  canvas.setTextColor(TFT_WHITE, TFT_BLACK);
+  canvas.printf("  last %u min", spanMinutes);
+  canvas.setTextFont(Layout::font);
+}
+
+void initTrendGraph() {
+  graph.begin(Layout::graph.w, Layout::graph.h, GRAPH_SPAN_MINUTES, false); // internal RAM, the whole sprite is pushed per scroll
+}
+
+void drawTrendGraphFrame() {
+  displayFence();
+  drawTrendLegend(tft, Layout::legend.x, Layout::legend.y, GRAPH_SPAN_MINUTES);
+  invalidateTrendGraph();
+}
+
+void invalidateTrendGraph() {
+  dirty = true; // the screen was cleared, push the graph again
+  fullPushDue = true;
+}
+
+void addTrendSample(const SensorSample &sample) {
+  if (!sample.valid()) {
+    return;
+  }
+
+  waitForSprite(graph.sprite()); // the last push may still be reading the sprite
+  fullPushDue |= graph.add(sample.t_decidegC, sample.rh_decipct, sample.ts);
+  dirty = true;
+}
+
+bool trendGraphDirty() {
+  return dirty;
+}
+
+void updateTrendGraph() {
+  if (fullPushDue) {
+    queueSpritePush(graph.sprite(), Layout::graph.x, Layout::graph.y, 0, 0, Layout::graph.w, Layout::graph.h);
+  } else {
+    const int16_t x = Layout::graph.w - 1; // only the newest column changed
+    queueSpritePush(graph.sprite(), Layout::graph.x + x, Layout::graph.y, x, 0, 1, Layout::graph.h);
+  }
+  dirty = false;
+  fullPushDue = false;
+}
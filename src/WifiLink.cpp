@@ -0,0 +1,90 @@
+/*********************************************************************************************************
+ * Wi-Fi Link
+ *
+ * How It Works:
+ *   1. The first wifiAcquire() switches the radio to station mode and waits for the association;
+ *       later calls only add a reference (and wait if a connection is still being set up). Modem
+ *       sleep is on while associated, except on a mesh aggregator, which must not miss a frame.
+ *   2. A failed connection drops its reference again, so a missing access point never leaves the
+ *       radio running.
+ *   3. The last wifiRelease() disconnects and switches the radio off, and adds the on-time. On a mesh
+ *       aggregator it only disconnects, the radio keeps listening for ESP-NOW frames.
+ *   4. The lock is created once by wifiBegin() in setup(), before any task that can acquire the link.
+**********************************************************************************************************/
+
+#include "WifiLink.h"
+
+#include <WiFi.h>
+
+namespace {
+SemaphoreHandle_t linkMutex = nullptr;
+uint8_t users = 0;
+uint32_t radioOnSince = 0;     // millis() when the radio was switched on
+uint32_t radioOnTotal = 0;     // accumulated on-time of previous sessions
+
+void lockLink() {
+  configASSERT(linkMutex != nullptr); // wifiBegin() was not called
+  xSemaphoreTake(linkMutex, portMAX_DELAY);
+}
+
+void unlockLink() {
+  xSemaphoreGive(linkMutex);
+}
+
+void radioOff() {
+#if MESH_ROLE == MESH_AGGREGATOR
+  WiFi.disconnect(); // the station stays up for ESP-NOW
+#else
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+#endif
+  radioOnTotal += millis() - radioOnSince;
+}
+}
+
+void wifiBegin() {
+  linkMutex = xSemaphoreCreateMutex();
+}
+
+bool wifiAcquire(uint32_t timeoutMs) {
+  lockLink();
+  if (users++ == 0) {
+    radioOnSince = millis();
+    WiFi.mode(WIFI_STA);
+#if MESH_ROLE == MESH_AGGREGATOR
+    WiFi.setSleep(false); // keep listening for the leaves' broadcasts between beacons
+#else
+    WiFi.setSleep(true); // modem sleep between beacons while associated
+#endif
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  }
+
+  // Wait for the association (the mutex is held, so a second user waits for the same connection)
+  uint32_t start = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
+    vTaskDelay(pdMS_TO_TICKS(50));
+  }
+
+  bool connected = WiFi.status() == WL_CONNECTED;
+  if (!connected && --users == 0) {
+    radioOff();
+  }
+  unlockLink();
+  return connected;
+}
+
+void wifiRelease() {
+  lockLink();
+  if (users > 0 && --users == 0) {
+    radioOff();
+  }
+  unlockLink();
+}
+
+bool wifiConnected() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+uint32_t wifiOnTimeMs() {
+  return radioOnTotal + (users > 0 ? millis() - radioOnSince : 0);
+}
@@ -0,0 +1,197 @@
+/*********************************************************************************************************
+ * Benchmark Harness ([env:bench])
+ *
+ * Description:
+ *   Replaces the application's setup()/loop() with a harness that times the display and sensor hot
+ *    paths over many iterations and prints the results once on serial (115200 baud).
+ *
+ * Output:
+ *   One CSV line per benchmark, all times in microseconds:
+ *     bench,<name>,<iterations>,<mean>,<min>,<max>,<total>
+ *   Lines starting with '#' are context (board, library versions) and can be skipped by a parser.
+ *
+ * Notes:
+ *   - Only the body of an iteration is timed, the preparation (e.g. dirtying a field) is not.
+ *   - DHT reads are spaced by SENSOR_READ_INTERVAL_MS, the sensor does not answer faster than that.
+ *   - The harness links the same Display/SensorTask code as the application, so results of two builds
+ *      compare the code and library versions, not a copy of them.
+**********************************************************************************************************/
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <esp_timer.h>
+#include "Config.h"
+#include "DerivedMetrics.h"
+#include "DhtSensor.h"
+#include "Display.h"
+#include "DisplayPush.h"
+#include "FixedFormat.h"
+#include "Layout.h"
+#include "SensorArray.h"
+#include "SensorTask.h"
+
+namespace {
+volatile size_t sink = 0; // results are folded in here so the optimizer keeps the work
+
+// Function to time a benchmark, prepare() runs before every iteration outside the timed region
+template <typename Prepare, typename Body>
+void runBench(const char *name, uint32_t iterations, Prepare prepare, Body body) {
+  uint32_t minUs = UINT32_MAX;
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    prepare(i);
+    int64_t start = esp_timer_get_time();
+    body(i);
+    uint32_t elapsed = esp_timer_get_time() - start;
+
+    totalUs += elapsed;
+    minUs = elapsed < minUs ? elapsed : minUs;
+    maxUs = elapsed > maxUs ? elapsed : maxUs;
+  }
+
+  Serial.printf("bench,%s,%lu,%lu,%lu,%lu,%llu\n", name, (unsigned long)iterations,
+                (unsigned long)(totalUs / iterations), (unsigned long)minUs, (unsigned long)maxUs,
+                (unsigned long long)totalUs);
+}
+
+template <typename Body>
+void runBench(const char *name, uint32_t iterations, Body body) {
+  runBench(name, iterations, [](uint32_t) {}, body);
+}
+
+// Function to print the build context of the results
+void printContext() {
+  Serial.printf("# chip=%s cpu=%luMHz idf=%s\n", ESP.getChipModel(), (unsigned long)getCpuFrequencyMhz(),
+                esp_get_idf_version());
+#ifdef ARDUINO_BOARD
+  Serial.printf("# board=%s\n", ARDUINO_BOARD);
+#endif
+#ifdef TFT_ESPI_VERSION
+  Serial.printf("# tft_espi=%s\n", TFT_ESPI_VERSION);
+#endif
+  Serial.printf("# sprite_fields=%d dht_backend=%d\n", USE_SPRITE_FIELDS, DHT_BACKEND);
+  Serial.println("# name,iterations,mean_us,min_us,max_us,total_us");
+}
+
+// Function to benchmark the screen paths
+void benchDisplay() {
+  runBench("draw_static_elements", BENCH_ITERATIONS, [](uint32_t) {
+    drawStaticElements();
+  });
+  updateDynamicElements(); // settle the fields and graph dirtied by the redraws
+  displayFence();
+
+  // Worst case: every glyph of a value changes (until the pixels are on the panel)
+  runBench("update_dynamic_full", BENCH_ITERATIONS,
+           [](uint32_t i) { setField(DisplayField::TEMPERATURE, (i & 1) ? "88.8 C" : "11.1 C"); },
+           [](uint32_t) { updateDynamicElements(); displayFence(); });
+
+  // Same, but only the time loop() is held up when the push runs in the background
+  runBench("update_dynamic_full_submit", BENCH_ITERATIONS,
+           [](uint32_t i) { displayFence(); setField(DisplayField::TEMPERATURE, (i & 1) ? "88.8 C" : "11.1 C"); },
+           [](uint32_t) { updateDynamicElements(); });
+  displayFence();
+
+  // Usual case: only the last digit changes
+  runBench("update_dynamic_digit", BENCH_ITERATIONS,
+           [](uint32_t i) { setField(DisplayField::TEMPERATURE, (i & 1) ? "23.4 C" : "23.5 C"); },
+           [](uint32_t) { updateDynamicElements(); displayFence(); });
+
+  runBench("update_dynamic_clean", BENCH_ITERATIONS, [](uint32_t) {
+    if (displayDirty()) {
+      updateDynamicElements();
+    }
+    displayFence();
+  });
+
+  // Sprite pushes of a field line and of a graph sized block
+  TFT_eSprite sprite = TFT_eSprite(&tft);
+  sprite.setColorDepth(16);
+  sprite.setAttribute(PSRAM_ENABLE, false);
+  if (sprite.createSprite(Layout::valueWidth, Layout::lineHeight) != nullptr) {
+    sprite.fillSprite(TFT_BLUE);
+    runBench("push_sprite_line", BENCH_ITERATIONS, [&](uint32_t) { sprite.pushSprite(0, 90); });
+    sprite.deleteSprite();
+  }
+  if (sprite.createSprite(Layout::graph.w, Layout::graph.h) != nullptr) {
+    sprite.fillSprite(TFT_NAVY);
+    runBench("push_sprite_block", BENCH_ITERATIONS, [&](uint32_t) { sprite.pushSprite(Layout::graph.x, Layout::graph.y); });
+    sprite.deleteSprite();
+  }
+
+  runBench("fill_screen", BENCH_ITERATIONS, [](uint32_t i) {
+    tft.fillScreen((i & 1) ? TFT_BLACK : TFT_DARKGREY);
+  });
+}
+
+// Function to benchmark value formatting, float String (the original) against fixed-point
+void benchFormatting() {
+  const uint32_t iterations = BENCH_ITERATIONS * 10;
+
+  runBench("format_string_float", iterations, [](uint32_t i) {
+    float value = (int16_t)(i % 1000) / 10.0f;
+    String text = String(value, 1) + " C";
+    sink = sink + text.length();
+  });
+
+  runBench("format_fixed_deci", iterations, [](uint32_t i) {
+    DeciText text;
+    sink = sink + formatDeci(text, (int16_t)(i % 1000), 'C');
+  });
+
+  // Derived metrics over a sweep of readings, float reference (logf/expf per call) against the table
+  runBench("derive_float", iterations, [](uint32_t i) {
+    float t = (int16_t)(i % 500) / 10.0f;
+    float rh = (float)(100 + i % 900) / 10.0f;
+    float gamma = logf(rh / 100.0f) + 17.62f * t / (243.12f + t);
+    float es = 6.112f * expf(17.62f * t / (243.12f + t));
+    sink = sink + (int32_t)(243.12f * gamma / (17.62f - gamma)) + (int32_t)(216.74f * es * rh / 100.0f / (273.15f + t));
+  });
+
+  runBench("derive_fixed", iterations, [](uint32_t i) {
+    DerivedSample derived = deriveMetrics((int16_t)(i % 500), (uint16_t)(100 + i % 900));
+    sink = sink + derived.dewPoint_decidegC + derived.absHumidity_decigm3;
+  });
+}
+
+// Function to benchmark a full sensor read (start pulse, capture, decode) of the primary sensor
+void benchSensor() {
+  DhtSensor &sensor = sensors[0];
+  sensor.begin();
+  uint32_t validReads = 0;
+
+  runBench("dht_read", BENCH_DHT_READS,
+           [](uint32_t i) {
+             if (i > 0) {
+               vTaskDelay(pdMS_TO_TICKS(SENSOR_READ_INTERVAL_MS));
+             }
+           },
+           [&](uint32_t) {
+             if (readSensor(sensor).valid()) {
+               validReads++;
+             }
+           });
+
+  Serial.printf("# dht_read valid=%lu/%lu\n", (unsigned long)validReads, (unsigned long)BENCH_DHT_READS);
+}
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000); // give the host time to open the port
+
+  initDisplay();
+  drawStaticElements();
+
+  printContext();
+  benchDisplay();
+  benchFormatting();
+  benchSensor();
+  Serial.println("# done");
+}
+
+void loop() {
+  vTaskDelay(portMAX_DELAY); // results are printed once
+}
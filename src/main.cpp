@@ -9,27 +9,82 @@
  *   The screen is only updated if there is a change in the sensor readings.
  *
  * How It Works:
- *   1. Sensor Reading: The code reads temperature and humidity data from the DHT11 sensor as float vaues
- *    at regular 2 second intervals.
+ *   1. Sensor Reading: The code reads temperature and humidity data from the DHT11 sensor as fixed-point
+ *    samples (tenths of a unit, both taken from the same frame) at regular 2 second intervals. The frame
+ *    is captured in the background by the RMT peripheral, from a dedicated sensor task pinned to core 0
+ *    that hands each reading to loop() through a lock-free queue.
+ *    Up to 8 DHT11/DHT22 sensors (SENSOR_PINS) are read round-robin with staggered start pulses and
+ *    shown in a compact table; the first one feeds the history, trend graph, flash log and telemetry.
+ *    With ADAPTIVE_SAMPLING the interval stretches up to ADAPTIVE_INTERVAL_MAX_MS while the readings are
+ *    stable and drops back to 2 seconds as soon as they start to move.
  *   2. Display: The sensor data is updated on the screen only when there is a difference in readings.
- *   3. State Machine: A state machine is used to manage the timing of sensor readings and display updates.
+ *    Readings first pass a median-of-N filter and a deadband, so ±1 LSB noise does not count as a change.
+ *    Every dynamic field has its own dirty bit and text cache, so only the glyphs that changed are pushed.
+ *    Dew point and heat index are derived in fixed point (DerivedMetrics.h), only when the filtered reading
+ *    changes, and shown below the humidity.
+ *    A scrolling trend graph below the values adds one column per time slot instead of being redrawn.
+ *   3. State Machine: A state machine in loop() consumes the readings and manages the display updates,
+ *    while the sensor task keeps the read cadence on its own core. Both tasks block between deadlines
+ *    (vTaskDelayUntil / task notification) instead of polling millis(), so the CPU idles in between.
  *   4. Sensor Check: If the sensor readings are 0 or invalid, it displays "Sensor Not Connected".
+ *    A quick line check fails a read at once when nothing is plugged in, retries back off exponentially,
+ *    and "DISCONNECTED" is drawn once when the sensor drops out, not on every failed read.
+ *   5. Telemetry (TELEMETRY): Optional batched HTTP uplink. Samples are coalesced and the radio only comes
+ *    up when a batch fills, a reading crosses its threshold or the batch gets too old.
+ *   6. Deep-Sleep Logging (DEEP_SLEEP_LOGGER): Optional build mode that takes one reading per wake, stores
+ *    it in an RTC memory ring buffer and deep-sleeps until the next reading. The display and serial port
+ *    only come up every DEEP_SLEEP_FLUSH_EVERY samples to flush the batch.
+ *   7. Display Power: The backlight is PWM-dimmed after BACKLIGHT_DIM_MS without activity and the panel
+ *    goes to sleep (backlight off, ST7789 SLPIN) after DISPLAY_SLEEP_MS. A button press or a significant
+ *    reading change (WAKE_DELTA_T/RH, or a sensor dropping out/coming back) wakes it.
+ *   8. Profiler (PROFILER): Every pass through the state machine is timed into a per-state histogram.
+ *    Min/max/mean/p99 and loops per second are printed on serial and shown in an overlay over the trend
+ *    graph, toggled with button 2 (GPIO14).
+ *   9. Metrics Server (METRICS_SERVER): Optional local HTTP server with a Prometheus /metrics endpoint and
+ *    a paged JSON /api/samples view of the history, streamed from a preallocated buffer.
+ *   10. Fleet Mesh (MESH_ROLE): Leaves broadcast every reading as a 10-byte ESP-NOW frame without ever
+ *    associating with an access point. The aggregator dedupes them, shows a fleet summary in place of the
+ *    trend graph and is the only unit with a Wi-Fi uplink.
+ *   11. Alarms (ALARMS): High/low and rate-of-change limits are checked in the sensor task as soon as a
+ *    reading lands. The alarm output (ALARM_PIN) switches from there, and a full-screen alert pre-empts
+ *    the state machine on its next pass. Any button acknowledges the alert, the output stays on until
+ *    the alarm clears.
+ *   12. Diagnostics (DIAGNOSTICS): Free heap, largest block, PSRAM, task stack watermarks, radio and
+ *    backlight on-time and an estimated mAh per hour, on the diagnostics page and on serial with the
+ *    "diag" command.
+ *   13. Pages: Button 1 (GPIO0) steps through the live, trend, min/max and diagnostics pages. Each page's
+ *    background is rendered once into a PSRAM sprite, so a switch is one push plus the page's values.
+ *   14. OTA Updates (OTA_UPDATE): A low-priority task streams new firmware into the inactive app slot
+ *    while sampling and the display carry on. The restart into it waits for a quiet point after a
+ *    reading was drawn, so an update costs one reboot.
  *
  * Pin Connections:
- *   - DHT11 Data Pin -> GPIO1
- *   - LCD Backlight  -> GPIO15
+ *   - DHT11 Data Pin -> GPIO1 (further sensors on the pins listed in SENSOR_PINS)
+ *   - LCD Backlight  -> GPIO38 (TFT_BL, PWM dimmed; GPIO15 is the panel power enable)
  *   - Ground         -> GND
  *   - Voltage        -> 5V
  *
  * Notes:
- *   - The DHT library is used to read data from the DHT11 sensor.
+ *   - The DhtSensor driver reads the DHT11 through the RMT peripheral (DHT_BACKEND_RMT), the Adafruit DHT
+ *      library is kept as a blocking fallback backend (DHT_BACKEND_ADAFRUIT).
  *   - The TFT_eSPI library is configured to work with the LilyGO T-Display-S3, providing an easy way to
  *      display information on the built-in screen.
  *   - DHT11 pinout: [-] = GND | [S] = Signal PIN | [MIDDLE PIN] = Supply Voltage PIN.
  *      (5V or 3.3V pins on the T-Display can be used to power the DHT11 but the resolution will be lower
  *       if the 3.3V pin is used.)
- *   - DHT11 uses float as the data-type, rounded to the 2nd decimal poition (00.00)
- * 
+ *   - Readings are kept as integers in tenths (the 0.1 sensor resolution) and formatted into stack
+ *      buffers by FixedFormat.h, so neither the samples nor the display path use floats or the heap.
+ *   - With USE_SPRITE_FIELDS enabled, each dynamic field is drawn into a small off-screen sprite and
+ *      pushed to the screen as one block, which removes the flicker of clearing and re-printing.
+ *   - Boot order is tuned for time-to-first-reading: the sensor task starts before the panel is
+ *      initialized, the static frame is blitted from a cache in flash, and the flash log is only
+ *      mounted once the first reading is on screen.
+ *   - With DISPLAY_ASYNC_PUSH enabled those pushes run in the background (DisplayPush.h), so loop() goes
+ *      back to waiting for the next sample while the pixels are still being transferred.
+ *   - The [env:native] build runs this sketch on the host against mocked DHT, TFT and FreeRTOS layers
+ *      (src/sim/), replaying a recorded sensor trace and counting what each loop() pass sends to the
+ *      panel, so redraw regressions show up without a board.
+ *
  * DHT11 Specifications:
  *   - Operating Voltage: 3V to 5V
  *   - Operating current: 0.3mA (measuring) 60uA (standby)
@@ -47,88 +102,373 @@
 
 #include <Arduino.h>
 #include <TFT_eSPI.h>
-#include <DHT.h>
-
-// TFT_eSPI
-TFT_eSPI tft = TFT_eSPI();
+#include <esp_timer.h>
+#include "Alarm.h"
+#include "Buttons.h"
+#include "Config.h"
+#include "DerivedMetrics.h"
+#include "DhtSensor.h"
+#include "Diagnostics.h"
+#include "Display.h"
+#include "DisplayPower.h"
+#include "DisplayPush.h"
+#include "FixedFormat.h"
+#include "FlashLog.h"
+#include "History.h"
+#include "Mesh.h"
+#include "MetricsServer.h"
+#include "OtaUpdate.h"
+#include "Pages.h"
+#include "Profiler.h"
+#include "SampleFilter.h"
+#include "SensorArray.h"
+#include "SensorTask.h"
+#include "Telemetry.h"
+#include "TrendGraph.h"
+#include "WifiLink.h"
+
+#if SCHEDULER_MODE == SCHEDULER_LIGHT_SLEEP
+#include <esp_pm.h>
+#endif
+
+#include <sys/time.h>
+
+#if DEEP_SLEEP_LOGGER
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#endif
 
 // DHT11 Sensor
-#define DHT11_PIN 1
-DHT dht11(DHT11_PIN, DHT11);
 
 // State Machine States
-enum class State {
-  READ_SENSOR,    // state for reading sensor data
+// (same order as ProfileSection, the profiler times each state under its own section)
+enum class State : uint8_t {
+  READ_SENSOR,    // state for taking a reading published by the sensor task
   UPDATE_DISPLAY, // state for updating the display
-  WAIT            // state for waiting between sensor reads
+  WAIT,           // state for sleeping until the sensor task publishes the next reading
+  ALERT           // state for drawing (or removing) the full-screen alarm alert, pre-empts the others
 };
 
 // Global variables
-State currentState = State::READ_SENSOR;       // initial state
-unsigned long previousMillis = 0;              // for non-blocking timing
-const unsigned long sensorReadInterval = 2000; // read sensor every 2 seconds (recommended interval)
-float temperature = 0.0;                       // variable to store temperature reading
-float humidity = 0.0;                          // variable to store humidity reading
-float previousTemperature = 0.0;               // store previous temperature value
-float previousHumidity = 0.0;                  // store previous humidity value
-bool redrawRequired = true;                    // flag to indicate when to redraw the screen
-bool sensorConnected = true;                   // flag to track sensor connection
+State currentState = State::WAIT;              // initial state (wait for the first sample)
+State resumeState = State::WAIT;               // state interrupted by an alarm, resumed after ALERT
+SensorSample latestSample;                     // last sample received from the sensor task
+bool sensorConnected[sensorCount];             // flag to track each sensor's connection
+SampleFilter<FILTER_MEDIAN_WINDOW> sampleFilters[sensorCount]; // noise filter per sensor
+SensorSample wakeReference[sensorCount];       // reading at the last significant change, per sensor
+DerivedSample derivedMetrics[sensorCount];     // dew point, heat index and absolute humidity, per sensor
+
+#if DEEP_SLEEP_LOGGER
+// Deep-sleep sample log, kept in RTC slow memory across deep sleep
+struct LoggedSample {
+  int16_t temperature; // °C x 10 (INT16_MIN if the read failed)
+  uint16_t humidity;   // % x 10
+  uint32_t timestamp;  // seconds since first power-up
+};
+RTC_DATA_ATTR LoggedSample loggedSamples[DEEP_SLEEP_BUFFER_SIZE]; // ring buffer of samples
+RTC_DATA_ATTR uint16_t loggedHead = 0;                            // next slot to write
+RTC_DATA_ATTR uint16_t loggedCount = 0;                           // samples not flushed yet
+RTC_DATA_ATTR uint32_t loggedOverwritten = 0;                     // samples lost to a full buffer
+#endif
 
 
 /*************************************************************
 ********************** HELPER FUNCTIONS **********************
 **************************************************************/
 
-// Function to draw static elements on the TFT screen
-void drawStaticElements() {
-  tft.fillScreen(TFT_BLACK);              // clear the screen
-  tft.setTextFont(2);                     // set the font
-  tft.setTextColor(TFT_WHITE, TFT_BLACK); // set text color and background
+// Function to set up the power management used while the tasks are blocked
+void configureScheduler() {
+#if SCHEDULER_MODE == SCHEDULER_LIGHT_SLEEP
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  esp_pm_config_esp32s3_t pmConfig = {};
+  pmConfig.max_freq_mhz = PM_MAX_FREQ_MHZ;
+  pmConfig.min_freq_mhz = PM_MIN_FREQ_MHZ;
+  pmConfig.light_sleep_enable = true; // sleep whenever every task is blocked long enough
+  esp_pm_configure(&pmConfig);
+#else
+#warning "SCHEDULER_LIGHT_SLEEP needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE, using SCHEDULER_BLOCKING"
+#endif
+#endif
+}
 
-  // Draw static text or elements
-  tft.setCursor(0, 0);
-  tft.println("---------------------------");
-  tft.println("- DHT11 Sensor Module -");
-  tft.println("---------------------------");
 
-  tft.setCursor(0, 70);
-  tft.println("Status:");
+// Function to get the system time in seconds (keeps running through deep sleep)
+uint32_t systemSeconds() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return now.tv_sec;
+}
 
-  tft.setCursor(0, 120);
-  tft.println("Temperature:");
+// Function to check a filtered sample against the reading at the last significant change
+bool significantChange(const SensorSample &sample) {
+  SensorSample &reference = wakeReference[sample.sensor];
+  bool significant = sample.valid() != reference.valid() ||
+                     (sample.valid() && (abs(sample.t_decidegC - reference.t_decidegC) >= WAKE_DELTA_T ||
+                                         abs((int32_t)sample.rh_decipct - reference.rh_decipct) >= WAKE_DELTA_RH));
+  if (significant) {
+    reference = sample;
+  }
+  return significant;
+}
 
-  tft.setCursor(0, 170);
-  tft.println("Humidity:");
+// Function to filter a sample and mark the fields that changed, true if the filtered reading moved
+bool showFilteredSample(const SensorSample &sample, SensorSample &filtered) {
+  sensorConnected[sample.sensor] = sample.valid(); // false if the sensor is not connected or malfunctioning
+
+  // Median and deadband filter, sensor noise stops here
+  filtered = sample;
+  bool changed = sampleFilters[sample.sensor].apply(filtered);
+  if (changed) {
+    DerivedSample &derived = derivedMetrics[sample.sensor];
+    if (filtered.valid()) {
+      derived = deriveMetrics(filtered.t_decidegC, filtered.rh_decipct); // only when the filtered reading moved
+    }
+
+    showSample(filtered); // only fields whose text changed become dirty
+    if (filtered.valid()) {
+      showDerived(derived);
+    }
+  }
+  return changed;
 }
 
-// Function to update dynamic elements on the TFT screen
-void updateDynamicElements() {
-  // Update sensor status
-  tft.setCursor(0, 90);  // move cursor to the line below "Status:"
-  tft.print("        "); // clear previous value
-  tft.setCursor(0, 90);
-  tft.print(sensorConnected ? "CONNECTED" : "DISCONNECTED");
-
-  // Update temperature
-  tft.setCursor(0, 140); // move cursor to the line below "Temperature:"
-  tft.print("        "); // clear previous value
-  tft.setCursor(0, 140);
-  if (sensorConnected) {
-    tft.print(String(temperature) + " C");
-  } else {
-    tft.print("N/A");
+// Function to show a published sample and hand it to the history, logs and uplinks
+void processSample(const SensorSample &sample) {
+  SensorSample filtered;
+  bool changed = showFilteredSample(sample, filtered);
+
+#if METRICS_SERVER
+  // Latest reading for the scrapers
+  metricsPublish(sample, derivedMetrics[sample.sensor]);
+#endif
+
+#if MESH_ROLE == MESH_LEAF
+  // Broadcast it to the aggregator
+  meshSend(sample);
+#endif
+
+  if (sample.sensor == 0) {
+    // Keep the raw samples of the primary sensor in the history store and the trend graph
+    history.append(sample);
+    addTrendSample(sample);
+
+#if FLASH_LOG
+    // Log it to flash, written a full page at a time
+    if (sample.valid()) {
+      flashLog.append(systemSeconds(), sample.t_decidegC, sample.rh_decipct);
+    }
+#endif
+
+#if TELEMETRY
+    // Coalesce it into the uplink batch
+    telemetryAdd(systemSeconds(), sample, derivedMetrics[sample.sensor]);
+#endif
+  }
+
+  // A connect/disconnect or a large move wakes the display
+  if (changed && significantChange(filtered)) {
+    displayActivity();
+  }
+}
+
+// Function to check if the alarm alert covers the screen
+bool alarmOnScreen() {
+#if ALARMS
+  return alarmScreenVisible();
+#else
+  return false;
+#endif
+}
+
+// Function to check if the screen has something to draw
+bool screenUpdateDue() {
+  if (!displayAwake() || alarmOnScreen()) {
+    return false;
   }
+  return pageDirty(); // only the page on screen counts, the others catch up when they are shown
+}
+
+// Function to run the initialization that can wait until the first reading is on screen
+void deferredInit() {
+  static bool done = false;
+  if (done) {
+    return;
+  }
+  done = true;
+
+#if FLASH_LOG
+  // Mount the flash log (formatting it on first use can take seconds)
+  flashLog.begin();
+#endif
+
+#if OTA_UPDATE
+  // A freshly updated image got its first reading on screen, keep it
+  otaConfirmImage();
+#endif
+}
+
+#if OTA_UPDATE
+// Function to restart into a downloaded firmware image once it is quiet: the reading was just drawn,
+//  the next one is a sample interval away and no alarm holds the output on
+void restartForUpdateIfQuiet() {
+  if (!otaRestartDue()) {
+    return;
+  }
+#if ALARMS
+  for (uint8_t sensor = 0; sensor < sensorCount; sensor++) {
+    if (activeAlarms(sensor) != 0) {
+      return; // the output would drop during the reboot, wait for the alarm to clear
+    }
+  }
+#endif
+
+  displayFence(); // the last pushes land before the reset
+#if FLASH_LOG
+  flashLog.flush();
+#endif
+  otaRestart();
+}
+#endif
+
+// Function to act on the buttons pressed since the last call
+void handleButtons(uint8_t presses) {
+  if (presses == 0) {
+    return;
+  }
+
+  // The press that wakes a sleeping display does nothing else
+  bool wasAwake = displayAwake();
+  displayActivity();
+  if (!wasAwake) {
+    return;
+  }
+
+#if ALARMS
+  if (alarmScreenVisible()) {
+    acknowledgeAlarm(); // any button, the output stays on until the alarm clears
+    return;
+  }
+#endif
+
+  if (presses & BUTTON_1) {
+    nextPage(); // drawn in UPDATE_DISPLAY
+  }
+
+#if PROFILER
+  if ((presses & BUTTON_2) && currentPage() == Page::LIVE) {
+    profilerToggleOverlay(); // the display catches up in UPDATE_DISPLAY
+  }
+#endif
+}
+
 
-  // Update humidity
-  tft.setCursor(0, 190); // move cursor to the line below "Humidity:"
-  tft.print("        "); // clear previous value
-  tft.setCursor(0, 190);
-  if (sensorConnected) {
-    tft.print(String(humidity) + " %");
+/*************************************************************
+********************* DEEP SLEEP LOGGER **********************
+**************************************************************/
+
+#if DEEP_SLEEP_LOGGER
+// Function to append a sample to the RTC ring buffer
+void logSample(const SensorSample &sample) {
+  LoggedSample &entry = loggedSamples[loggedHead];
+  entry.temperature = sample.valid() ? sample.t_decidegC : INT16_MIN;
+  entry.humidity = sample.valid() ? sample.rh_decipct : 0;
+  entry.timestamp = systemSeconds();
+
+  loggedHead = (loggedHead + 1) % DEEP_SLEEP_BUFFER_SIZE;
+  if (loggedCount < DEEP_SLEEP_BUFFER_SIZE) {
+    loggedCount++;
   } else {
-    tft.print("N/A");
+    loggedOverwritten++; // oldest unflushed sample overwritten
+  }
+}
+
+// Function to bring up the display and serial port and flush the logged batch
+void flushLog() {
+  Serial.begin(115200);
+  Serial.println("timestamp,temperature,humidity");
+
+#if FLASH_LOG
+  // The batch also goes to the flash log, one page write per flush
+  flashLog.begin();
+#endif
+
+  uint16_t index = (loggedHead + DEEP_SLEEP_BUFFER_SIZE - loggedCount) % DEEP_SLEEP_BUFFER_SIZE;
+  for (uint16_t i = 0; i < loggedCount; i++) {
+    const LoggedSample &sample = loggedSamples[index];
+    if (sample.temperature == INT16_MIN) {
+      Serial.printf("%lu,,\n", (unsigned long)sample.timestamp);
+    } else {
+      DeciText temperatureText, humidityText;
+      formatDeci(temperatureText, sample.temperature);
+      formatDeci(humidityText, (int16_t)sample.humidity);
+      Serial.printf("%lu,%s,%s\n", (unsigned long)sample.timestamp, temperatureText, humidityText);
+#if FLASH_LOG
+      flashLog.append(sample.timestamp, sample.temperature, sample.humidity);
+#endif
+#if TELEMETRY
+      SensorSample batched = { sample.temperature, sample.humidity, 0, SampleStatus::OK, 0 };
+      telemetryAdd(sample.timestamp, batched, deriveMetrics(sample.temperature, sample.humidity));
+#endif
+    }
+    index = (index + 1) % DEEP_SLEEP_BUFFER_SIZE;
+  }
+  if (loggedOverwritten > 0) {
+    Serial.printf("# %lu samples overwritten\n", (unsigned long)loggedOverwritten);
+  }
+  Serial.flush();
+#if FLASH_LOG
+  flashLog.flush();
+#endif
+#if TELEMETRY
+  // One radio wake for the whole batch
+  telemetrySendNow();
+#endif
+
+  // Show the latest reading
+  initDisplay();
+  drawStaticElements();
+  updateDynamicElements();
+  displayFence(); // the panel goes to sleep after this, the pushes must have landed
+
+  loggedCount = 0;
+  loggedOverwritten = 0;
+}
+
+// Function to run one wake cycle: read, log, flush every N samples, then deep-sleep
+void runDeepSleepCycle() {
+#ifdef TFT_BL
+  gpio_hold_dis((gpio_num_t)TFT_BL); // release the backlight pin held during deep sleep
+#endif
+
+  // Read the primary sensor (same read and checks as the READ_SENSOR state)
+  sensors[0].begin();
+  SensorSample sample = readSensor(sensors[0]);
+  SensorSample filtered;
+  showFilteredSample(sample, filtered); // fields for the flush screen, the batch below is the only log
+  logSample(sample);
+#if MESH_ROLE == MESH_LEAF
+  meshSendNow(sample); // the radio is up for a few milliseconds, no association
+#endif
+
+  // Flush the batch every N samples
+  if (loggedCount >= DEEP_SLEEP_FLUSH_EVERY) {
+    flushLog();
+    delay(2000);                    // leave the flushed values on screen for a moment
+    tft.writecommand(ST7789_SLPIN); // put the panel to sleep along with the chip
   }
+
+#ifdef TFT_BL
+  // Keep the backlight off while asleep
+  pinMode(TFT_BL, OUTPUT);
+  digitalWrite(TFT_BL, LOW);
+  gpio_hold_en((gpio_num_t)TFT_BL);
+  gpio_deep_sleep_hold_en();
+#endif
+
+  esp_sleep_enable_timer_wakeup((uint64_t)SENSOR_READ_INTERVAL_MS * 1000);
+  esp_deep_sleep_start();
 }
+#endif
 
 
 /*************************************************************
@@ -137,75 +477,178 @@ void updateDynamicElements() {
 
 // SETUP
 void setup() {
-  // Initialize the TFT display
-  tft.init();
-  tft.setRotation(0);                     // adjust rotation (0 & 2 portrait | 1 & 3 landscape)
-  tft.fillScreen(TFT_BLACK);              // black background
-  tft.setTextFont(2);                     // set the font (you can experiment with different fonts)
-  tft.setTextColor(TFT_WHITE, TFT_BLACK); // set text colour (white) and background colour (black)
+#if TELEMETRY || METRICS_SERVER || OTA_UPDATE
+  // The shared Wi-Fi link lock, before any task (or the deep-sleep flush) can acquire the link
+  wifiBegin();
+#endif
+
+#if DEEP_SLEEP_LOGGER
+  // Logging mode: one reading per wake, never returns
+  runDeepSleepCycle();
+#endif
 
-  // Initialize the DHT11 sensor
-  dht11.begin();
+  // Set up sleeping between deadlines
+  configureScheduler();
 
-  // Draw static elements once
+#if ALARMS
+  // Alarm output, and the loop task as the one woken by alarm events (before the first read lands)
+  alarmsBegin();
+#endif
+
+  // Initialize the DHT sensors and start sampling them round-robin on core 0. The first start pulse
+  //  goes out while the panel below is still being initialized, the sample waits in the queue.
+  startSensorTask();
+
+  // Allocate the sample history (older samples spill into PSRAM)
+  history.begin();
+
+  // Initialize the TFT display and draw static elements once (blitted from the cached frame)
+  initDisplay();
   drawStaticElements();
 
-  // Initial display update
-  redrawRequired = true; // update display
+  // Take over the backlight with PWM once the frame is on the panel
+  displayPowerBegin();
+
+#if MESH_ROLE != MESH_OFF
+  // Join the fleet mesh (an aggregator's loop task is woken by every received frame)
+  meshBegin();
+#endif
+
+#if TELEMETRY
+  // Start the batched uplink
+  telemetryBegin();
+#endif
+
+#if METRICS_SERVER
+  // Serve /metrics and /api/samples on the local network
+  metricsServerBegin();
+#endif
+
+#if OTA_UPDATE
+  // Check for new firmware in the background
+  otaBegin();
+#endif
+
+  // Buttons wake the loop task out of its WAIT state
+  buttonsBegin();
+
+#if PROFILER || DIAGNOSTICS
+  Serial.begin(115200);
+#endif
+#if DIAGNOSTICS
+  // "diag" on serial prints the diagnostics report
+  diagnosticsBegin();
+#endif
 }
 
 // MAIN LOOP
 void loop() {
-  unsigned long currentMillis = millis(); // get the current millis time
+#if ALARMS
+  // An alarm pre-empts whatever the state machine was about to do, the interrupted state resumes after it
+  if (currentState != State::ALERT && alarmPending()) {
+    resumeState = currentState;
+    currentState = State::ALERT;
+  }
+#endif
+
+#if PROFILER
+  State profiledState = currentState;
+  int64_t stateStart = esp_timer_get_time();
+#endif
 
   // State Machine Logic
   switch (currentState) {
     case State::READ_SENSOR:
-      // Read sensor data
-      temperature = dht11.readTemperature();
-      humidity = dht11.readHumidity();
-
-      // Check if readings are valid
-      if (isnan(temperature) || isnan(humidity)) {
-        sensorConnected = false; // sensor not connected or malfunctioning
-      }
-      else {
-        sensorConnected = true;  // sensor is connected and working
-      }
-
-      // Check if the readings have changed
-      if (temperature != previousTemperature || humidity != previousHumidity || !sensorConnected) {
-        redrawRequired = true;             // update display
-        previousTemperature = temperature; // update previous temperature
-        previousHumidity = humidity;       // update previous humidity
-      }
+      // Take the sample published by the sensor task
+      processSample(latestSample);
 
       // Move to the next state
       currentState = State::UPDATE_DISPLAY;
       break;
 
     case State::UPDATE_DISPLAY:
-      // Update the display with the new sensor data
-      if (redrawRequired) {
-        updateDynamicElements();
-        redrawRequired = false; // reset the flag
+      // Update the display with the new sensor data (fields stay dirty while the panel sleeps)
+      if (screenUpdateDue()) {
+        updatePage(); // the live page queues its dirty fields, the pushes run on core 0
       }
 
+      // The first reading is on screen, finish the slow part of the boot
+      deferredInit();
+
+#if OTA_UPDATE
+      // Between two WAIT cycles is the quiet point for the restart into a downloaded update
+      restartForUpdateIfQuiet();
+#endif
+
       // Move to the WAIT state
       currentState = State::WAIT;
-      previousMillis = currentMillis; // record the previous millis time
       break;
 
-    case State::WAIT:
-      // Wait for the specified interval before reading the sensor again
-      if (currentMillis - previousMillis >= sensorReadInterval) {
+    case State::WAIT: {
+      // Block until the sensor task publishes the next reading or a button is pressed, the core sleeps
+      //  in the meantime
+      TickType_t timeout = pdMS_TO_TICKS(2 * SENSOR_BACKOFF_MAX_MS);
+#if PROFILER
+      if (profilerOverlayVisible() && currentPage() == Page::LIVE) {
+        timeout = pdMS_TO_TICKS(PROFILER_OVERLAY_MS); // keep the overlay live
+      }
+#endif
+#if DIAGNOSTICS
+      if (currentPage() == Page::DIAG && pdMS_TO_TICKS(DIAG_PAGE_MS) < timeout) {
+        timeout = pdMS_TO_TICKS(DIAG_PAGE_MS); // keep the page live
+      }
+#endif
+#if MESH_ROLE == MESH_AGGREGATOR
+      if (pdMS_TO_TICKS(MESH_VIEW_MS) < timeout) {
+        timeout = pdMS_TO_TICKS(MESH_VIEW_MS); // draw frames held back by the redraw limit
+      }
+#endif
+      uint32_t powerTimeout = displayPowerTimeoutMs(); // wake up for the next dim/sleep step
+      if (powerTimeout != UINT32_MAX && pdMS_TO_TICKS(powerTimeout) < timeout) {
+        timeout = pdMS_TO_TICKS(powerTimeout);
+      }
+      bool sampleReady = waitForSensorSample(latestSample, timeout);
+      handleButtons(takeButtonPresses());
+#if DIAGNOSTICS
+      diagnosticsPollSerial(); // commands typed on serial, the receive callback ends the wait at once
+#endif
+#if MESH_ROLE == MESH_AGGREGATOR
+      meshPoll(); // frames from the leaves, the fleet view turns dirty on a new reading
+#endif
+      if (alarmOnScreen()) {
+        displayActivity(); // the alert stays lit until it is acknowledged
+      }
+      updateDisplayPower();
+
+      if (sampleReady) {
         currentState = State::READ_SENSOR;
+      } else if (screenUpdateDue()) {
+        currentState = State::UPDATE_DISPLAY;
       }
       break;
+    }
+
+#if ALARMS
+    case State::ALERT:
+      // Draw the alert for the new alarms, or give the screen back once they cleared
+      handleAlarmEvents();
+
+      // Go back to the interrupted state
+      currentState = resumeState;
+      break;
+#endif
 
     default:
       // Default case (should not happen)
-      currentState = State::READ_SENSOR;
+      currentState = State::WAIT;
       break;
   }
+
+#if PROFILER
+  profilerRecord(static_cast<ProfileSection>(static_cast<uint8_t>(profiledState)), esp_timer_get_time() - stateStart);
+  profilerLoopTick();
+  if (profilerReportDue()) {
+    profilerReport(Serial);
+  }
+#endif
 }
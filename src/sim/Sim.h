@@ -0,0 +1,60 @@
+/*********************************************************************************************************
+ * Host Simulation ([env:native])
+ *
+ * Description:
+ *   Internal interface between the pieces of the native build:
+ *   - SimScheduler.cpp  simulated clock and the FreeRTOS task model
+ *   - SimTrace.cpp      recorded sensor trace and button presses, the DHT mock
+ *   - SimArduino.cpp    GPIO, Serial, heap, NVS and Wi-Fi mocks
+ *   - SimDisplay.cpp    TFT_eSPI mock and its draw counters
+ *   - SimMain.cpp       main(): runs setup()/loop() over a trace and checks the draw budgets
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace sim {
+
+// Scheduler
+void startScheduler(const char *taskName, uint32_t priority); // the calling thread becomes a task
+uint64_t nowUs();                                             // simulated time since boot
+void busyUs(uint64_t us);                                     // the running task keeps the core for us
+void scheduleEvent(uint64_t atUs, void (*handler)(uint32_t), uint32_t arg); // runs as an interrupt
+void setEndUs(uint64_t endUs);                                // the run stops once time passes this
+
+// Trace
+struct SensorState {
+  bool connected; // the data line is pulled up
+  bool answers;   // a read returns a frame
+  float temperature;
+  float humidity;
+};
+bool loadTrace(const char *path, uint64_t &lastUs); // false on a missing file or a bad line
+bool isSensorPin(uint8_t pin);
+SensorState sensorState(uint8_t pin);               // state due at the current time
+uint32_t sensorReads();                             // reads answered by the DHT mock
+
+// GPIO
+void fireInterrupt(uint8_t pin);                    // call the handler attached to a pin
+uint32_t pinEdges(uint8_t pin);                     // level changes written to an output pin
+uint8_t pinLevel(uint8_t pin);
+
+// Display
+struct DisplayCounters {
+  uint32_t calls;        // draw calls on the panel
+  uint32_t fillScreens;
+  uint32_t fillRects;    // including lines and pixels
+  uint32_t texts;        // drawString/print runs
+  uint32_t images;       // pushImage/pushImageDMA
+  uint32_t spritePushes;
+  uint32_t commands;     // writecommand()
+  uint64_t bytes;        // bytes sent to the panel
+  uint32_t spriteCalls;  // draw calls into sprites (no bus traffic)
+};
+const DisplayCounters &displayCounters();
+DisplayCounters operator-(const DisplayCounters &a, const DisplayCounters &b);
+
+// Harness
+[[noreturn]] void finish(const char *reason); // print the summary and exit
+}
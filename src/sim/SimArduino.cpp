@@ -0,0 +1,201 @@
+/*********************************************************************************************************
+ * Arduino Core Mocks ([env:native])
+ *
+ * Description:
+ *   Host implementations of the GPIO, interrupt, Serial, heap, NVS and Wi-Fi calls. Inputs read the
+ *    trace (a sensor pin is high while its sensor is connected, button pins idle high), outputs are
+ *    recorded so the harness can report the edges of e.g. the alarm pin.
+**********************************************************************************************************/
+
+#include <map>
+#include <stdarg.h>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+#include "Sim.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+namespace {
+const uint8_t pinCount = 49; // GPIO0-48 on the ESP32-S3
+
+uint8_t levels[pinCount] = {};
+uint32_t edges[pinCount] = {};
+void (*handlers[pinCount])() = {};
+
+std::map<std::string, std::vector<uint8_t>> nvs; // "namespace/key" -> value
+}
+
+namespace sim {
+void fireInterrupt(uint8_t pin) {
+  if (pin < pinCount && handlers[pin] != nullptr) {
+    handlers[pin]();
+  }
+}
+
+uint32_t pinEdges(uint8_t pin) {
+  return pin < pinCount ? edges[pin] : 0;
+}
+
+uint8_t pinLevel(uint8_t pin) {
+  return pin < pinCount ? levels[pin] : LOW;
+}
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < pinCount && mode == INPUT_PULLUP) {
+    levels[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < pinCount && levels[pin] != level) {
+    levels[pin] = level;
+    edges[pin]++;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  if (sim::isSensorPin(pin)) {
+    return sim::sensorState(pin).connected ? HIGH : LOW; // the module's pull-up against the weak pull-down
+  }
+  return pin < pinCount ? levels[pin] : LOW;
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+  (void)mode; // presses from the trace are falling edges
+  if (pin < pinCount) {
+    handlers[pin] = handler;
+  }
+}
+
+void ledcSetup(uint8_t channel, uint32_t frequency, uint8_t resolution) {
+  (void)channel;
+  (void)frequency;
+  (void)resolution;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+  (void)pin;
+  (void)channel;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+  (void)channel;
+  (void)duty;
+}
+
+void *ps_malloc(size_t size) {
+  return malloc(size);
+}
+
+bool psramFound() {
+  return true;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  (void)caps;
+  return malloc(size);
+}
+
+void *heap_caps_calloc(size_t count, size_t size, uint32_t caps) {
+  (void)caps;
+  return calloc(count, size);
+}
+
+void heap_caps_free(void *pointer) {
+  free(pointer);
+}
+
+size_t Print::print(int value) {
+  return printf("%d", value);
+}
+
+size_t Print::println(const char *text) {
+  return print(text) + print("\n");
+}
+
+size_t Print::printf(const char *format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) {
+    return 0;
+  }
+  return write(reinterpret_cast<const uint8_t *>(text), (size_t)length < sizeof(text) ? length : sizeof(text) - 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer, 1, size, stderr);
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return 250000; // heap use is not simulated
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  return 250000;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+  return 110000;
+}
+
+uint32_t EspClass::getFreePsram() {
+  return getPsramSize();
+}
+
+void EspClass::restart() {
+  sim::finish("ESP.restart()");
+}
+
+bool Preferences::begin(const char *name, bool readOnly) {
+  snprintf(_name, sizeof(_name), "%s", name);
+  if (!readOnly) {
+    return true;
+  }
+  // A read-only open fails until something was written to the namespace, as on a blank NVS partition
+  std::string prefix = std::string(_name) + "/";
+  auto entry = nvs.lower_bound(prefix);
+  return entry != nvs.end() && entry->first.compare(0, prefix.size(), prefix) == 0;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  auto entry = nvs.find(std::string(_name) + "/" + key);
+  return entry == nvs.end() ? 0 : entry->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t size) {
+  auto entry = nvs.find(std::string(_name) + "/" + key);
+  if (entry == nvs.end() || entry->second.size() > size) {
+    return 0;
+  }
+  memcpy(buffer, entry->second.data(), entry->second.size());
+  return entry->second.size();
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(value);
+  nvs[std::string(_name) + "/" + key].assign(bytes, bytes + size);
+  return size;
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+  uint32_t value = defaultValue;
+  return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
@@ -0,0 +1,267 @@
+/*********************************************************************************************************
+ * TFT_eSPI Mock ([env:native])
+ *
+ * How It Works:
+ *   1. Each call on the panel object adds one draw call and its pixels times 2 bytes to the counters,
+ *       and keeps the simulated core busy for the transfer (the 8-bit parallel bus moves about
+ *       20 bytes/us), so a heavier frame also shows up as a later wake of the lower priority tasks.
+ *   2. Text is a filled glyph box: the font's fixed cell times the characters, widened to the text
+ *       padding, which is what TFT_eSPI sends with a background color set.
+ *   3. Calls on a sprite draw into its pixel buffer and count as sprite calls only; pushSprite() is
+ *       the panel transfer.
+**********************************************************************************************************/
+
+#include <TFT_eSPI.h>
+#include "Sim.h"
+
+namespace {
+const uint64_t busBytesPerUs = 20;
+
+sim::DisplayCounters counters = {};
+
+struct FontCell {
+  uint8_t width;
+  uint8_t height;
+};
+
+FontCell fontCell(uint8_t font) {
+  switch (font) {
+  case 2:
+    return { 8, 16 };
+  case 4:
+    return { 14, 26 };
+  default:
+    return { 6, 8 };
+  }
+}
+}
+
+namespace sim {
+const DisplayCounters &displayCounters() {
+  return counters;
+}
+
+DisplayCounters operator-(const DisplayCounters &a, const DisplayCounters &b) {
+  return { a.calls - b.calls,   a.fillScreens - b.fillScreens, a.fillRects - b.fillRects,
+           a.texts - b.texts,   a.images - b.images,           a.spritePushes - b.spritePushes,
+           a.commands - b.commands, a.bytes - b.bytes,         a.spriteCalls - b.spriteCalls };
+}
+}
+
+TFT_eSPI::TFT_eSPI(int16_t width, int16_t height) : _width(width), _height(height) {}
+
+void TFT_eSPI::init() {
+  count(counters.commands, 0);
+}
+
+void TFT_eSPI::setRotation(uint8_t rotation) {
+  _rotation = rotation & 3;
+  if (!_isSprite) {
+    _width = _rotation & 1 ? TFT_HEIGHT : TFT_WIDTH;
+    _height = _rotation & 1 ? TFT_WIDTH : TFT_HEIGHT;
+    count(counters.commands, 0);
+  }
+}
+
+void TFT_eSPI::writecommand(uint8_t command) {
+  (void)command;
+  count(counters.commands, 0);
+}
+
+void TFT_eSPI::count(uint32_t &calls, uint64_t pixels) {
+  if (_isSprite) {
+    counters.spriteCalls++;
+    return;
+  }
+  calls++;
+  counters.calls++;
+  counters.bytes += pixels * 2;
+  sim::busyUs(pixels * 2 / busBytesPerUs);
+}
+
+void TFT_eSPI::fill(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  (void)color;
+  // Clip to the panel like the library does, off-screen parts are not sent
+  int32_t x0 = x < 0 ? 0 : x;
+  int32_t y0 = y < 0 ? 0 : y;
+  int32_t x1 = x + w > _width ? _width : x + w;
+  int32_t y1 = y + h > _height ? _height : y + h;
+  uint64_t pixels = x1 > x0 && y1 > y0 ? (uint64_t)(x1 - x0) * (y1 - y0) : 0;
+  count(counters.fillRects, pixels);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+  if (_isSprite) {
+    fill(0, 0, _width, _height, color);
+    return;
+  }
+  count(counters.fillScreens, (uint64_t)_width * _height);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  fill(x, y, w, h, color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+  fill(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+  fill(x, y, 1, h, color);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  fill(x, y, 1, 1, color);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+  (void)x;
+  (void)y;
+  (void)data;
+  count(counters.images, (uint64_t)w * h);
+}
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data, uint16_t *buffer) {
+  (void)buffer;
+  pushImage(x, y, w, h, data);
+}
+
+int16_t TFT_eSPI::textWidth(const char *text, uint8_t font) const {
+  return strlen(text) * fontCell(font).width;
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font) const {
+  return fontCell(font).height;
+}
+
+int16_t TFT_eSPI::drawString(const char *text, int32_t x, int32_t y) {
+  int16_t width = textWidth(text);
+  int16_t boxWidth = width > _padding ? width : _padding;
+  if (_isSprite) {
+    fill(x, y, boxWidth, fontHeight(_font), TFT_BLACK);
+  } else {
+    count(counters.texts, (uint64_t)boxWidth * fontHeight(_font));
+  }
+  return width;
+}
+
+int16_t TFT_eSPI::drawCentreString(const char *text, int32_t x, int32_t y, uint8_t font) {
+  uint8_t previous = _font;
+  _font = font;
+  int16_t width = drawString(text, x - textWidth(text) / 2, y);
+  _font = previous;
+  return width;
+}
+
+size_t TFT_eSPI::write(const uint8_t *buffer, size_t size) {
+  FontCell cell = fontCell(_font);
+  if (_isSprite) {
+    fill(_cursorX, _cursorY, size * cell.width, cell.height, TFT_BLACK);
+  } else {
+    count(counters.texts, (uint64_t)size * cell.width * cell.height);
+  }
+  for (size_t i = 0; i < size; i++) {
+    if (buffer[i] == '\n') {
+      _cursorX = 0;
+      _cursorY += cell.height;
+    } else {
+      _cursorX += cell.width;
+    }
+  }
+  return size;
+}
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *panel) : TFT_eSPI(0, 0), _panel(panel) {
+  _isSprite = true;
+}
+
+TFT_eSprite::~TFT_eSprite() {
+  deleteSprite();
+}
+
+void *TFT_eSprite::createSprite(int16_t width, int16_t height, uint8_t frames) {
+  (void)frames;
+  deleteSprite();
+  _pixels = static_cast<uint16_t *>(calloc((size_t)width * height, sizeof(uint16_t)));
+  if (_pixels != nullptr) {
+    _width = width;
+    _height = height;
+  }
+  return _pixels;
+}
+
+void TFT_eSprite::deleteSprite() {
+  free(_pixels);
+  _pixels = nullptr;
+  _width = 0;
+  _height = 0;
+}
+
+void TFT_eSprite::fill(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  counters.spriteCalls++;
+  if (_pixels == nullptr) {
+    return;
+  }
+  for (int32_t row = y < 0 ? 0 : y; row < y + h && row < _height; row++) {
+    for (int32_t column = x < 0 ? 0 : x; column < x + w && column < _width; column++) {
+      _pixels[row * _width + column] = color;
+    }
+  }
+}
+
+uint16_t TFT_eSprite::readPixel(int32_t x, int32_t y) const {
+  if (_pixels == nullptr || x < 0 || y < 0 || x >= _width || y >= _height) {
+    return 0;
+  }
+  return _pixels[y * _width + x];
+}
+
+void TFT_eSprite::scroll(int16_t dx, int16_t dy) {
+  counters.spriteCalls++;
+  if (_pixels == nullptr) {
+    return;
+  }
+  // Shift the buffer, the uncovered area is filled with black like the library's default scroll colour
+  uint16_t *copy = static_cast<uint16_t *>(malloc((size_t)_width * _height * sizeof(uint16_t)));
+  if (copy == nullptr) {
+    return;
+  }
+  memcpy(copy, _pixels, (size_t)_width * _height * sizeof(uint16_t));
+  for (int32_t row = 0; row < _height; row++) {
+    for (int32_t column = 0; column < _width; column++) {
+      int32_t fromX = column - dx;
+      int32_t fromY = row - dy;
+      bool inside = fromX >= 0 && fromX < _width && fromY >= 0 && fromY < _height;
+      _pixels[row * _width + column] = inside ? copy[fromY * _width + fromX] : TFT_BLACK;
+    }
+  }
+  free(copy);
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  (void)x;
+  (void)y;
+  (void)_panel;
+  if (_pixels == nullptr) {
+    return;
+  }
+  counters.spritePushes++;
+  counters.calls++;
+  counters.bytes += (uint64_t)_width * _height * 2;
+  sim::busyUs((uint64_t)_width * _height * 2 / busBytesPerUs);
+}
+
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh) {
+  (void)tx;
+  (void)ty;
+  (void)sx;
+  (void)sy;
+  if (_pixels == nullptr) {
+    return false;
+  }
+  counters.spritePushes++;
+  counters.calls++;
+  counters.bytes += (uint64_t)sw * sh * 2;
+  sim::busyUs((uint64_t)sw * sh * 2 / busBytesPerUs);
+  return true;
+}
@@ -0,0 +1,190 @@
+/*********************************************************************************************************
+ * Native Simulation Harness ([env:native])
+ *
+ * Description:
+ *   Runs the unmodified sketch (setup() once, then loop() forever) on the host against a recorded
+ *    sensor trace, with the simulated clock of SimScheduler.cpp, and reports what reached the panel:
+ *      .pio/build/native/program <trace.csv> [--frames <file.csv>] [--tail-ms <ms>] [--settle-ms <ms>]
+ *                                [--max-fill-screen <n>] [--max-frame-bytes <n>] [--max-frame-calls <n>]
+ *   A frame is everything drawn during one pass of loop() (setup() is the boot frame and is not held
+ *    to the budgets). --frames writes one CSV row per frame that drew something; the --max options
+ *    fail the run when any frame after boot (and after --settle-ms, to leave out the first readings)
+ *    exceeds them, so a trace plus its budgets is a regression check for the redraw paths.
+ *
+ * How It Works:
+ *   1. The trace is loaded (sensor rows and button presses), the run ends --tail-ms (default 10 s)
+ *       after its last row.
+ *   2. The calling thread becomes the Arduino loop task and runs setup() and loop(); the sensor and
+ *       display tasks setup() starts run on their own threads, one at a time.
+ *   3. Once the simulated clock passes the end of the run (or every task blocks forever) the summary
+ *       is printed and the process exits with the result.
+ *
+ * Notes:
+ *   Exit status: 0 = within budget, 1 = a budget was exceeded, 2 = usage, trace or deadlock error.
+ *   Serial output of the sketch goes to stderr, the summary to stdout.
+**********************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <Arduino.h>
+#include "Config.h"
+#include "Sim.h"
+
+void setup();
+void loop();
+
+namespace {
+struct Budget {
+  const char *option;
+  uint64_t limit;
+  uint64_t worst;     // worst frame after boot
+  uint32_t worstFrame;
+};
+
+enum BudgetIndex { FILL_SCREEN, FRAME_BYTES, FRAME_CALLS, BUDGET_COUNT };
+
+Budget budgets[BUDGET_COUNT] = {
+  { "--max-fill-screen", UINT64_MAX, 0, 0 },
+  { "--max-frame-bytes", UINT64_MAX, 0, 0 },
+  { "--max-frame-calls", UINT64_MAX, 0, 0 },
+};
+
+FILE *framesFile = nullptr;
+uint64_t settleUs = 0;     // frames starting earlier are not held to the budgets
+uint32_t frameCount = 0;   // frames that drew something, boot included
+uint32_t loopPasses = 0;
+
+void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s <trace.csv> [--frames <file.csv>] [--tail-ms <ms>] [--settle-ms <ms>]\n"
+          "          [--max-fill-screen <n>] [--max-frame-bytes <n>] [--max-frame-calls <n>]\n",
+          program);
+  exit(2);
+}
+
+// Account one frame: write its row and hold it to the budgets
+void recordFrame(uint64_t startUs, const sim::DisplayCounters &frame, bool boot) {
+  if (frame.calls == 0 && frame.spriteCalls == 0) {
+    return;
+  }
+  if (framesFile != nullptr) {
+    fprintf(framesFile, "%u,%llu,%d,%u,%u,%u,%u,%u,%u,%u,%llu,%u\n", frameCount, (unsigned long long)startUs, boot,
+            frame.calls, frame.fillScreens, frame.fillRects, frame.texts, frame.images, frame.spritePushes,
+            frame.commands, (unsigned long long)frame.bytes, frame.spriteCalls);
+  }
+  if (!boot && startUs >= settleUs) {
+    const uint64_t values[BUDGET_COUNT] = { frame.fillScreens, frame.bytes, frame.calls };
+    for (uint8_t i = 0; i < BUDGET_COUNT; i++) {
+      if (values[i] > budgets[i].worst) {
+        budgets[i].worst = values[i];
+        budgets[i].worstFrame = frameCount;
+      }
+    }
+  }
+  frameCount++;
+}
+}
+
+namespace sim {
+void finish(const char *reason) {
+  if (framesFile != nullptr) {
+    fclose(framesFile);
+  }
+
+  const DisplayCounters &total = displayCounters();
+  printf("sim: %s at %.3f s\n", reason != nullptr ? reason : "end of trace", nowUs() / 1e6);
+  printf("  loop passes %u, frames drawn %u, sensor reads %u\n", loopPasses, frameCount, sensorReads());
+  printf("  panel: %u calls, %u fillScreen, %u fillRect, %u text, %u image, %u sprite push, %llu bytes\n",
+         total.calls, total.fillScreens, total.fillRects, total.texts, total.images, total.spritePushes,
+         (unsigned long long)total.bytes);
+#if ALARMS
+  printf("  alarm pin: %u edges, level %u\n", pinEdges(ALARM_PIN), pinLevel(ALARM_PIN));
+#endif
+
+  int status = reason != nullptr && strncmp(reason, "every task", 10) == 0 ? 2 : 0;
+  for (const Budget &budget : budgets) {
+    bool over = budget.worst > budget.limit;
+    printf("  %-18s worst %llu (frame %u)", budget.option + 2, (unsigned long long)budget.worst, budget.worstFrame);
+    if (budget.limit != UINT64_MAX) {
+      printf(", limit %llu%s", (unsigned long long)budget.limit, over ? "  OVER BUDGET" : "");
+    }
+    printf("\n");
+    if (over && status == 0) {
+      status = 1;
+    }
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  _Exit(status); // the task threads are parked in the scheduler, do not unwind them
+}
+}
+
+int main(int argc, char **argv) {
+  const char *tracePath = nullptr;
+  const char *framesPath = nullptr;
+  uint64_t tailMs = 10000;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-') {
+      if (tracePath != nullptr) {
+        usage(argv[0]);
+      }
+      tracePath = argv[i];
+      continue;
+    }
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+    }
+    const char *value = argv[++i];
+    if (strcmp(argv[i - 1], "--frames") == 0) {
+      framesPath = value;
+    } else if (strcmp(argv[i - 1], "--tail-ms") == 0) {
+      tailMs = strtoull(value, nullptr, 10);
+    } else if (strcmp(argv[i - 1], "--settle-ms") == 0) {
+      settleUs = strtoull(value, nullptr, 10) * 1000;
+    } else {
+      bool known = false;
+      for (Budget &budget : budgets) {
+        if (strcmp(argv[i - 1], budget.option) == 0) {
+          budget.limit = strtoull(value, nullptr, 10);
+          known = true;
+        }
+      }
+      if (!known) {
+        usage(argv[0]);
+      }
+    }
+  }
+  if (tracePath == nullptr) {
+    usage(argv[0]);
+  }
+
+  sim::startScheduler("loopTask", 1);
+  uint64_t lastUs;
+  if (!sim::loadTrace(tracePath, lastUs)) {
+    return 2;
+  }
+  sim::setEndUs(lastUs + tailMs * 1000);
+
+  if (framesPath != nullptr) {
+    framesFile = fopen(framesPath, "w");
+    if (framesFile == nullptr) {
+      fprintf(stderr, "sim: cannot write %s\n", framesPath);
+      return 2;
+    }
+    fprintf(framesFile, "frame,start_us,boot,calls,fill_screen,fill_rect,text,image,sprite_push,command,bytes,"
+                        "sprite_calls\n");
+  }
+
+  sim::DisplayCounters before = sim::displayCounters();
+  setup();
+  recordFrame(0, sim::displayCounters() - before, true);
+
+  while (true) {
+    uint64_t startUs = sim::nowUs();
+    before = sim::displayCounters();
+    loop();
+    loopPasses++;
+    recordFrame(startUs, sim::displayCounters() - before, false);
+  }
+}
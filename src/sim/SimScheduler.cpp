@@ -0,0 +1,360 @@
+/*********************************************************************************************************
+ * Simulated Scheduler ([env:native])
+ *
+ * How It Works:
+ *   1. Every FreeRTOS task is a host thread with its own condition variable. Exactly one task holds
+ *       the core (running); all others wait on their condition variable, so the code under test never
+ *       runs concurrently and needs no host synchronization of its own.
+ *   2. A task gives up the core only where FreeRTOS would block it: a delay, a notification or
+ *       semaphore wait that cannot be satisfied, or a higher priority task made ready by a notify or
+ *       give. The next task is the highest priority ready one, first come first served within a
+ *       priority.
+ *   3. When no task is ready, the clock jumps to the earliest timeout or scheduled interrupt. The
+ *       code under test takes no simulated time except for busyUs() (the panel bus transfers).
+ *   4. Scheduled interrupts (button presses from the trace) run on the thread that advanced the
+ *       clock, with FromISR semantics: they may make tasks ready but never switch.
+ *   5. Once the clock passes the end of the run, or every task blocks forever, sim::finish() prints
+ *       the results and ends the process.
+**********************************************************************************************************/
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "Sim.h"
+
+// One simulated task
+struct SimTask {
+  std::string name;
+  uint32_t priority;
+  uint32_t stackBytes;
+  bool ready = true;
+  uint64_t readyOrder = 0;            // first come first served within a priority
+  uint64_t wakeUs = UINT64_MAX;       // timeout while blocked
+  bool waitingForNotify = false;
+  SimSemaphore *waitingFor = nullptr;
+  uint32_t notifyCount = 0;
+  std::condition_variable_any turn;   // signalled when the task gets the core
+};
+
+// Counting semaphore, a mutex is one with a count of 1 (no priority inheritance)
+struct SimSemaphore {
+  uint32_t count;
+  uint32_t max;
+};
+
+namespace {
+typedef std::unique_lock<std::recursive_mutex> Guard;
+
+std::recursive_mutex schedulerLock;
+std::vector<SimTask *> tasks;
+SimTask *running = nullptr;
+thread_local SimTask *self = nullptr;
+uint64_t now = 0;
+uint64_t endUs = UINT64_MAX;
+uint64_t readySequence = 0;
+std::multimap<uint64_t, std::pair<void (*)(uint32_t), uint32_t>> events;
+
+void makeReady(SimTask *task) {
+  if (!task->ready) {
+    task->ready = true;
+    task->readyOrder = ++readySequence;
+    task->wakeUs = UINT64_MAX;
+    task->waitingForNotify = false;
+    task->waitingFor = nullptr;
+  }
+}
+
+SimTask *pickReady() {
+  SimTask *best = nullptr;
+  for (SimTask *task : tasks) {
+    if (task->ready && (best == nullptr || task->priority > best->priority ||
+                        (task->priority == best->priority && task->readyOrder < best->readyOrder))) {
+      best = task;
+    }
+  }
+  return best;
+}
+
+// Move the clock to the next timeout or interrupt, with no task ready
+void advanceClock() {
+  uint64_t next = events.empty() ? UINT64_MAX : events.begin()->first;
+  for (SimTask *task : tasks) {
+    if (!task->ready && task->wakeUs < next) {
+      next = task->wakeUs;
+    }
+  }
+  if (next == UINT64_MAX) {
+    sim::finish("every task is blocked forever");
+  }
+  if (next > endUs) {
+    now = endUs;
+    sim::finish(nullptr);
+  }
+  if (next > now) {
+    now = next;
+  }
+
+  while (!events.empty() && events.begin()->first <= now) {
+    auto event = events.begin()->second;
+    events.erase(events.begin());
+    event.first(event.second);
+  }
+  for (SimTask *task : tasks) {
+    if (!task->ready && task->wakeUs <= now) {
+      makeReady(task);
+    }
+  }
+}
+
+// Hand the core to the next task and wait until the calling task gets it back
+void reschedule(Guard &guard) {
+  SimTask *next;
+  while ((next = pickReady()) == nullptr) {
+    advanceClock();
+  }
+  if (next == self) {
+    return;
+  }
+  running = next;
+  next->turn.notify_one();
+  self->turn.wait(guard, [] { return running == self && self->ready; });
+}
+
+// Block the calling task until it is made ready again or the timeout in ticks expires
+void block(Guard &guard, TickType_t timeout) {
+  self->ready = false;
+  self->wakeUs = timeout == portMAX_DELAY ? UINT64_MAX : now + (uint64_t)timeout * 1000;
+  reschedule(guard);
+}
+
+// Let a task made ready by the running one take over if it has a higher priority
+void preemptFor(Guard &guard, SimTask *task) {
+  if (self != nullptr && task->ready && task->priority > self->priority) {
+    self->readyOrder = ++readySequence;
+    reschedule(guard);
+  }
+}
+
+struct TaskStart {
+  SimTask *task;
+  void (*code)(void *);
+  void *arg;
+};
+
+void taskThread(TaskStart start) {
+  {
+    Guard guard(schedulerLock);
+    self = start.task;
+    self->turn.wait(guard, [] { return running == self; });
+  }
+  start.code(start.arg);
+  vTaskDelete(nullptr); // returning from a task function is not allowed on FreeRTOS either
+}
+}
+
+namespace sim {
+void startScheduler(const char *taskName, uint32_t priority) {
+  Guard guard(schedulerLock);
+  SimTask *task = new SimTask();
+  task->name = taskName;
+  task->priority = priority;
+  task->stackBytes = 8192; // Arduino loop task
+  tasks.push_back(task);
+  self = task;
+  running = task;
+}
+
+uint64_t nowUs() {
+  return now;
+}
+
+void busyUs(uint64_t us) {
+  Guard guard(schedulerLock);
+  now += us;
+}
+
+void scheduleEvent(uint64_t atUs, void (*handler)(uint32_t), uint32_t arg) {
+  Guard guard(schedulerLock);
+  events.emplace(atUs, std::make_pair(handler, arg));
+}
+
+void setEndUs(uint64_t end) {
+  endUs = end;
+}
+}
+
+unsigned long millis() {
+  return now / 1000;
+}
+
+unsigned long micros() {
+  return now;
+}
+
+int64_t esp_timer_get_time() {
+  return now;
+}
+
+void delay(uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  sim::busyUs(us); // a busy wait on the real chip
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*code)(void *), const char *name, uint32_t stackBytes, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  (void)core; // one simulated core
+  Guard guard(schedulerLock);
+  SimTask *task = new SimTask();
+  task->name = name;
+  task->priority = priority;
+  task->stackBytes = stackBytes;
+  task->readyOrder = ++readySequence;
+  tasks.push_back(task);
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  std::thread(taskThread, TaskStart{ task, code, arg }).detach();
+  preemptFor(guard, task);
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return self;
+}
+
+TaskHandle_t xTaskGetHandle(const char *name) {
+  Guard guard(schedulerLock);
+  for (SimTask *task : tasks) {
+    if (task->name == name) {
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return task->stackBytes; // stack use is not simulated
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  Guard guard(schedulerLock);
+  SimTask *victim = task != nullptr ? task : self;
+  victim->ready = false;
+  victim->wakeUs = UINT64_MAX;
+  victim->name += " (deleted)";
+  if (victim == self) {
+    reschedule(guard); // never returns the core to this thread
+  }
+}
+
+TickType_t xTaskGetTickCount() {
+  return now / 1000;
+}
+
+TickType_t xTaskGetTickCountFromISR() {
+  return now / 1000;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  Guard guard(schedulerLock);
+  if (ticks == 0) {
+    self->readyOrder = ++readySequence; // yield to tasks of the same priority
+    reschedule(guard);
+    return;
+  }
+  block(guard, ticks);
+}
+
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t increment) {
+  Guard guard(schedulerLock);
+  *previousWake += increment;
+  uint64_t wake = (uint64_t)*previousWake * 1000;
+  if (wake > now) {
+    block(guard, (wake - now + 999) / 1000);
+  }
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  Guard guard(schedulerLock);
+  task->notifyCount++;
+  if (task->waitingForNotify) {
+    makeReady(task);
+    preemptFor(guard, task);
+  }
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityWoken) {
+  Guard guard(schedulerLock);
+  task->notifyCount++;
+  if (task->waitingForNotify) {
+    makeReady(task);
+  }
+  if (higherPriorityWoken != nullptr) {
+    *higherPriorityWoken = pdFALSE;
+  }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout) {
+  Guard guard(schedulerLock);
+  if (self->notifyCount == 0 && timeout > 0) {
+    self->waitingForNotify = true;
+    block(guard, timeout);
+  }
+  uint32_t count = self->notifyCount;
+  if (count > 0) {
+    self->notifyCount = clearOnExit ? 0 : count - 1;
+  }
+  return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return new SimSemaphore{ 0, 1 };
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new SimSemaphore{ 1, 1 };
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+  Guard guard(schedulerLock);
+  uint64_t deadline = timeout == portMAX_DELAY ? UINT64_MAX : now + (uint64_t)timeout * 1000;
+  while (semaphore->count == 0) {
+    if (now >= deadline) {
+      return pdFALSE;
+    }
+    self->waitingFor = semaphore;
+    block(guard, deadline == UINT64_MAX ? portMAX_DELAY : (deadline - now + 999) / 1000);
+  }
+  semaphore->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  Guard guard(schedulerLock);
+  if (semaphore->count >= semaphore->max) {
+    return pdFALSE;
+  }
+  semaphore->count++;
+
+  // Wake the highest priority waiter, it takes the count when it runs
+  SimTask *waiter = nullptr;
+  for (SimTask *task : tasks) {
+    if (!task->ready && task->waitingFor == semaphore && (waiter == nullptr || task->priority > waiter->priority)) {
+      waiter = task;
+    }
+  }
+  if (waiter != nullptr) {
+    makeReady(waiter);
+    preemptFor(guard, waiter);
+  }
+  return pdTRUE;
+}
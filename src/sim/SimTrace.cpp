@@ -0,0 +1,193 @@
+/*********************************************************************************************************
+ * Trace Replay ([env:native])
+ *
+ * Description:
+ *   Loads a recorded sensor trace and answers the DHT mock and the sensor pins from it. A trace is a
+ *    CSV file, one event per line, '#' starts a comment:
+ *      <ms>,<sensor>,<T °C>,<RH %>   from <ms> on, sensor <sensor> (index into SENSOR_PINS) reads T/RH
+ *      <ms>,<sensor>,timeout         the sensor is on the bus but does not answer
+ *      <ms>,<sensor>,nc              the sensor is unplugged (data line low against the pull-down)
+ *      <ms>,button,<1|2>             BUTTON_1 or BUTTON_2 is pressed at <ms>
+ *   Each sensor keeps the state of its last row until the next one; before its first row it does not
+ *    answer. The run ends --tail-ms after the last row (SimMain.cpp).
+ *
+ * Notes:
+ *   A read costs what it costs the library on the chip: the start pulse is a delay() that lets the
+ *    other tasks run (18 ms for a DHT11, 1 ms for a DHT22), the frame a busy wait of about 4 ms, or
+ *    the library's timeout when the sensor stays silent.
+**********************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <DHT.h>
+#include "Config.h"
+#include "Sim.h"
+
+namespace {
+const uint8_t pins[] = SENSOR_PINS;
+const uint8_t sensorCount = sizeof(pins) / sizeof(pins[0]);
+
+struct Row {
+  uint64_t atUs;
+  sim::SensorState state;
+};
+
+std::vector<Row> rows[sensorCount]; // per sensor, in time order
+uint32_t reads = 0;
+
+int sensorIndex(uint8_t pin) {
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (pins[i] == pin) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void onPress(uint32_t pin) {
+  sim::fireInterrupt(pin);
+}
+
+// Parse one non-empty, non-comment line, false if it is malformed
+bool parseLine(char *line, uint64_t &lastUs) {
+  char *fields[4] = {};
+  uint8_t count = 0;
+  for (char *field = strtok(line, ","); field != nullptr && count < 4; field = strtok(nullptr, ",")) {
+    while (*field == ' ') {
+      field++;
+    }
+    fields[count++] = field;
+  }
+  if (count < 3) {
+    return false;
+  }
+
+  char *end;
+  uint64_t atUs = strtoull(fields[0], &end, 10) * 1000;
+  if (end == fields[0]) {
+    return false;
+  }
+  if (atUs > lastUs) {
+    lastUs = atUs;
+  }
+
+  if (strcmp(fields[1], "button") == 0) {
+    int button = atoi(fields[2]);
+    if (button != 1 && button != 2) {
+      return false;
+    }
+    sim::scheduleEvent(atUs, onPress, button == 1 ? BUTTON_1_PIN : BUTTON_2_PIN);
+    return true;
+  }
+
+  long sensor = strtol(fields[1], &end, 10);
+  if (end == fields[1] || sensor < 0 || sensor >= sensorCount) {
+    return false;
+  }
+  Row row = { atUs, { true, false, NAN, NAN } };
+  if (strncmp(fields[2], "timeout", 7) == 0) {
+    // On the bus, silent
+  } else if (strncmp(fields[2], "nc", 2) == 0) {
+    row.state.connected = false;
+  } else if (count == 4) {
+    row.state.answers = true;
+    row.state.temperature = strtof(fields[2], nullptr);
+    row.state.humidity = strtof(fields[3], nullptr);
+  } else {
+    return false;
+  }
+  if (!rows[sensor].empty() && rows[sensor].back().atUs > atUs) {
+    return false; // out of order
+  }
+  rows[sensor].push_back(row);
+  return true;
+}
+}
+
+namespace sim {
+bool loadTrace(const char *path, uint64_t &lastUs) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "sim: cannot open %s\n", path);
+    return false;
+  }
+
+  char line[128];
+  uint32_t number = 0;
+  bool ok = true;
+  lastUs = 0;
+  while (ok && fgets(line, sizeof(line), file) != nullptr) {
+    number++;
+    char *comment = strchr(line, '#');
+    if (comment != nullptr) {
+      *comment = '\0';
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+    if (strspn(line, " \t") == strlen(line)) {
+      continue;
+    }
+    if (!parseLine(line, lastUs)) {
+      fprintf(stderr, "sim: %s:%u: bad trace line\n", path, number);
+      ok = false;
+    }
+  }
+  fclose(file);
+  return ok;
+}
+
+bool isSensorPin(uint8_t pin) {
+  return sensorIndex(pin) >= 0;
+}
+
+SensorState sensorState(uint8_t pin) {
+  int index = sensorIndex(pin);
+  SensorState state = { true, false, NAN, NAN };
+  if (index < 0) {
+    return state;
+  }
+  uint64_t now = nowUs();
+  for (const Row &row : rows[index]) {
+    if (row.atUs > now) {
+      break;
+    }
+    state = row.state;
+  }
+  return state;
+}
+
+uint32_t sensorReads() {
+  return reads;
+}
+}
+
+bool DHT::read(bool force) {
+  (void)force;
+  delay(_type == DHT11 ? 18 : 1); // start pulse
+  sim::SensorState state = sim::sensorState(_pin);
+  _valid = state.connected && state.answers;
+  sim::busyUs(_valid ? 4000 : 1000); // frame, or the library's response timeout
+  if (_valid) {
+    _temperature = state.temperature;
+    _humidity = state.humidity;
+    reads++;
+  }
+  return _valid;
+}
+
+float DHT::readTemperature(bool fahrenheit, bool force) {
+  if (force && !read(true)) {
+    return NAN;
+  }
+  if (!_valid) {
+    return NAN;
+  }
+  return fahrenheit ? _temperature * 1.8f + 32 : _temperature;
+}
+
+float DHT::readHumidity(bool force) {
+  if (force && !read(true)) {
+    return NAN;
+  }
+  return _valid ? _humidity : NAN;
+}
@@ -0,0 +1,95 @@
+/*********************************************************************************************************
+ * Arduino Core Mock ([env:native])
+ *
+ * Description:
+ *   The part of the Arduino-ESP32 API the project uses, on the host. Time is the simulated clock of
+ *    SimScheduler.cpp, GPIO levels come from the replayed trace, Serial goes to stderr.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+#define PROGMEM
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+#define FALLING 0x02
+
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+
+void ledcSetup(uint8_t channel, uint32_t frequency, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+void *ps_malloc(size_t size);
+bool psramFound();
+
+// Text output, everything funnels into write(buffer, size)
+class Print {
+public:
+  virtual ~Print() = default;
+  virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t print(const char *text) { return write(reinterpret_cast<const uint8_t *>(text), strlen(text)); }
+  size_t print(int value);
+  size_t println(const char *text = "");
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void flush() {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void onReceive(void (*callback)(), bool onlyOnTimeout = false) { (void)callback; (void)onlyOnTimeout; }
+  size_t write(const uint8_t *buffer, size_t size) override;
+};
+
+extern HardwareSerial Serial;
+
+// Chip information, fixed values of an ESP32-S3 with 8 MB PSRAM
+class EspClass {
+public:
+  const char *getChipModel() { return "ESP32-S3 (native)"; }
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getHeapSize() { return 327680; }
+  uint32_t getPsramSize() { return 8u << 20; }
+  uint32_t getFreePsram();
+  void restart();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,31 @@
+/*********************************************************************************************************
+ * Adafruit DHT Mock ([env:native])
+ *
+ * Description:
+ *   The DHT class of the Adafruit library, answering from the replayed trace (SimTrace.cpp): a read
+ *    returns the trace row of the sensor's pin that is due at the simulated time.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type, uint8_t count = 6) : _pin(pin), _type(type) { (void)count; }
+
+  void begin(uint8_t pullTime = 55) { (void)pullTime; }
+  bool read(bool force = false);                                 // false if the sensor does not answer
+  float readTemperature(bool fahrenheit = false, bool force = false); // NAN after a failed read
+  float readHumidity(bool force = false);
+
+private:
+  uint8_t _pin;
+  uint8_t _type;
+  bool _valid = false;
+  float _temperature = NAN;
+  float _humidity = NAN;
+};
@@ -0,0 +1,25 @@
+/*********************************************************************************************************
+ * Preferences Mock ([env:native])
+ *
+ * Description:
+ *   NVS key/value store kept in host memory for the length of a run, so the static frame cache is
+ *    missed on the first boot and hit afterwards, as on a freshly flashed board.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false);
+  void end() {}
+  size_t getBytesLength(const char *key);
+  size_t getBytes(const char *key, void *buffer, size_t size);
+  size_t putBytes(const char *key, const void *value, size_t size);
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+  size_t putUInt(const char *key, uint32_t value);
+
+private:
+  char _name[16] = {};
+};
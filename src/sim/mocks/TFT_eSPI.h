@@ -0,0 +1,111 @@
+/*********************************************************************************************************
+ * TFT_eSPI Mock ([env:native])
+ *
+ * Description:
+ *   Counts what the project sends to the panel instead of drawing it (SimDisplay.cpp): every call on
+ *    the panel object is one draw call, and the bytes it would put on the bus are added up (RGB565,
+ *    2 bytes per pixel, text as its glyph box with the background filled). Sprites keep a real pixel
+ *    buffer, so readPixel(), fillSprite() and the DMA pointer behave, but only their pushes reach
+ *    the panel. Glyphs are not rasterized; text is sized with a fixed cell per font.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_DARKGREY 0x7BEF
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+
+#define TFT_WIDTH 170
+#define TFT_HEIGHT 320
+#define TFT_BL 38
+
+#define ST7789_SLPIN 0x10
+#define ST7789_SLPOUT 0x11
+
+#define PSRAM_ENABLE 3
+#define TL_DATUM 0
+
+class TFT_eSPI : public Print {
+public:
+  TFT_eSPI(int16_t width = TFT_WIDTH, int16_t height = TFT_HEIGHT);
+
+  void init();
+  void setRotation(uint8_t rotation);
+  uint8_t getRotation() const { return _rotation; }
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+  void writecommand(uint8_t command);
+  void startWrite() {}
+  void endWrite() {}
+  bool initDMA(bool chipSelect = false) { (void)chipSelect; return true; }
+  void dmaWait() {}
+  void setSwapBytes(bool swap) { (void)swap; }
+
+  void fillScreen(uint32_t color);
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+  void drawPixel(int32_t x, int32_t y, uint32_t color);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data, uint16_t *buffer = nullptr);
+
+  void setTextFont(uint8_t font) { _font = font; }
+  void setTextColor(uint16_t foreground, uint16_t background) { (void)foreground; (void)background; }
+  void setTextDatum(uint8_t datum) { (void)datum; }
+  uint16_t setTextPadding(uint16_t width) { _padding = width; return width; }
+  void setCursor(int16_t x, int16_t y) { _cursorX = x; _cursorY = y; }
+  int16_t textWidth(const char *text, uint8_t font) const;
+  int16_t textWidth(const char *text) const { return textWidth(text, _font); }
+  int16_t fontHeight(int16_t font) const;
+  int16_t drawString(const char *text, int32_t x, int32_t y);
+  int16_t drawCentreString(const char *text, int32_t x, int32_t y, uint8_t font);
+  size_t write(const uint8_t *buffer, size_t size) override; // print()/printf() at the cursor
+  using Print::write;
+
+protected:
+  virtual void fill(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color); // sprite: into the buffer
+  void count(uint32_t &calls, uint64_t pixels);  // panel only
+
+  bool _isSprite = false;
+  int16_t _width;
+  int16_t _height;
+  uint8_t _rotation = 0;
+  uint8_t _font = 1;
+  uint16_t _padding = 0;
+  int16_t _cursorX = 0;
+  int16_t _cursorY = 0;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+  explicit TFT_eSprite(TFT_eSPI *panel);
+  ~TFT_eSprite();
+
+  void *createSprite(int16_t width, int16_t height, uint8_t frames = 1);
+  void deleteSprite();
+  bool created() const { return _pixels != nullptr; }
+  void *setColorDepth(int8_t bits) { (void)bits; return _pixels; }
+  void setAttribute(uint8_t attribute, uint8_t value) { (void)attribute; (void)value; }
+  void *getPointer() { return _pixels; }
+
+  void fillSprite(uint32_t color) { fill(0, 0, _width, _height, color); }
+  uint16_t readPixel(int32_t x, int32_t y) const;
+  void scroll(int16_t dx, int16_t dy = 0);
+  void pushSprite(int32_t x, int32_t y);
+  bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh);
+
+protected:
+  void fill(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+
+private:
+  TFT_eSPI *_panel;
+  uint16_t *_pixels = nullptr;
+};
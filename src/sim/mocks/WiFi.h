@@ -0,0 +1,28 @@
+/*********************************************************************************************************
+ * WiFi Mock ([env:native])
+ *
+ * Description:
+ *   Station control as used by WifiLink: the link "associates" at once and never drops. The network
+ *    features themselves (TELEMETRY, METRICS_SERVER, MESH_ROLE) are not part of the native build.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+enum wifi_mode_t { WIFI_OFF, WIFI_STA };
+enum wl_status_t { WL_IDLE_STATUS, WL_CONNECTED, WL_DISCONNECTED };
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t mode) { _on = mode != WIFI_OFF; return true; }
+  bool setSleep(bool enabled) { (void)enabled; return true; }
+  wl_status_t begin(const char *ssid, const char *password) { (void)ssid; (void)password; return status(); }
+  bool disconnect(bool wifiOff = false) { if (wifiOff) { _on = false; } return true; }
+  wl_status_t status() const { return _on ? WL_CONNECTED : WL_DISCONNECTED; }
+
+private:
+  bool _on = false;
+};
+
+extern WiFiClass WiFi;
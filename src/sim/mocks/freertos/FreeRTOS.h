@@ -0,0 +1,29 @@
+/*********************************************************************************************************
+ * FreeRTOS Mock ([env:native])
+ *
+ * Description:
+ *   Tasks, notifications, delays and semaphores on a simulated single core (SimScheduler.cpp). Every
+ *    task is a host thread, but only one of them runs at a time and the clock only moves while all of
+ *    them are blocked, so a run is deterministic and the code under test takes no simulated time.
+ *    One tick is one millisecond, as in the Arduino-ESP32 build.
+**********************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef struct SimTask *TaskHandle_t;
+typedef struct SimSemaphore *SemaphoreHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+#define configASSERT(x) assert(x)